@@ -0,0 +1,75 @@
+/* PNG predictor kernels: each SIMD kernel is checked against the scalar one on random rows, then both are timed undoing 16000-byte rows (4000
+RGBA or 5333 RGB pixels) of 3 & 4 byte pixels. usage: bench_predictors [row count] */
+#include "pdf_parser.cpp"
+#include <chrono>
+#include <random>
+
+using namespace pdf_parser;
+
+namespace {
+    using subKernel = void (*)(uint8_t*, std::size_t, std::size_t);
+    using upKernel = void (*)(uint8_t*, const uint8_t*, std::size_t);
+    using predictKernel = void (*)(uint8_t*, const uint8_t*, std::size_t, std::size_t);
+
+    predictorKernels scalar_kernels() {
+        return { unfilter_sub_scalar, unfilter_up_scalar, unfilter_average_scalar, unfilter_paeth_scalar };
+    }
+
+    // MB of rows undone per second, rows being undone in place over & over
+    template <typename Undo>
+    double throughput(std::size_t row_count, std::size_t row_size, Undo undo) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < row_count; ++i) undo();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return static_cast<double>(row_count * row_size) / seconds / 1e6;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t row_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000;
+    const predictorKernels scalar = scalar_kernels();
+    const predictorKernels& fastest = get_predictor_kernels();
+    std::mt19937 rng(5);
+
+    // odd sizes & every pixel size cover the kernels' tails & their scalar fallbacks
+    int mismatches = 0;
+    for (std::size_t bpp : { 1, 2, 3, 4, 6, 8 }) {
+        for (std::size_t size : { 0, 1, 3, 4, 7, 12, 33, 100, 999 }) {
+            std::vector<uint8_t> row(size), up(size);
+            for (uint8_t& byte : row) byte = static_cast<uint8_t>(rng());
+            for (uint8_t& byte : up) byte = static_cast<uint8_t>(rng());
+            auto check = [&](const char* name, auto undo_scalar, auto undo_fastest) {
+                std::vector<uint8_t> expected = row, actual = row;
+                undo_scalar(expected.data());
+                undo_fastest(actual.data());
+                if (expected != actual) {
+                    ++mismatches;
+                    std::printf("mismatch: %s, %zu byte pixels, %zu byte row\n", name, bpp, size);
+                }
+            };
+            check("sub", [&](uint8_t* cur) { scalar.sub(cur, size, bpp); }, [&](uint8_t* cur) { fastest.sub(cur, size, bpp); });
+            check("up", [&](uint8_t* cur) { scalar.up(cur, up.data(), size); }, [&](uint8_t* cur) { fastest.up(cur, up.data(), size); });
+            check("average", [&](uint8_t* cur) { scalar.average(cur, up.data(), size, bpp); }, [&](uint8_t* cur) { fastest.average(cur, up.data(), size, bpp); });
+            check("paeth", [&](uint8_t* cur) { scalar.paeth(cur, up.data(), size, bpp); }, [&](uint8_t* cur) { fastest.paeth(cur, up.data(), size, bpp); });
+        }
+    }
+    std::printf("%d mismatches between the scalar & selected kernels\n", mismatches);
+
+    const std::size_t row_size = 16000;
+    std::vector<uint8_t> row(row_size), up(row_size);
+    for (uint8_t& byte : row) byte = static_cast<uint8_t>(rng());
+    for (uint8_t& byte : up) byte = static_cast<uint8_t>(rng());
+    for (std::size_t bpp : { 3, 4 }) {
+        std::printf("%zu byte pixels, MB/s (scalar -> selected):\n", bpp);
+        auto compare = [&](const char* name, auto undo_scalar, auto undo_fastest) {
+            double scalar_rate = throughput(row_count, row_size, undo_scalar);
+            double fastest_rate = throughput(row_count, row_size, undo_fastest);
+            std::printf("  %-8s %8.0f -> %8.0f\n", name, scalar_rate, fastest_rate);
+        };
+        compare("sub", [&] { scalar.sub(row.data(), row_size, bpp); }, [&] { fastest.sub(row.data(), row_size, bpp); });
+        compare("up", [&] { scalar.up(row.data(), up.data(), row_size); }, [&] { fastest.up(row.data(), up.data(), row_size); });
+        compare("average", [&] { scalar.average(row.data(), up.data(), row_size, bpp); }, [&] { fastest.average(row.data(), up.data(), row_size, bpp); });
+        compare("paeth", [&] { scalar.paeth(row.data(), up.data(), row_size, bpp); }, [&] { fastest.paeth(row.data(), up.data(), row_size, bpp); });
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+/* how much of a document is read before its first page is available, through a byteSource standing in for range requests over a network: it
+serves ranges from a local file, sleeping for a fixed latency per request. usage: bench_range_source <pdf> [latency ms] */
+#include "pdf_parser.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace pdf_parser;
+
+namespace {
+    class delayedFileSource : public byteSource {
+    public:
+        delayedFileSource(std::FILE* file, std::chrono::milliseconds latency) : file(file), latency(latency) {
+            std::fseek(file, 0, SEEK_END);
+            file_size = static_cast<std::size_t>(std::ftell(file));
+        }
+        ~delayedFileSource() override { std::fclose(file); }
+
+        std::size_t size() override { return file_size; }
+
+        bool read(std::size_t offset, std::size_t length, char* out) override {
+            std::this_thread::sleep_for(latency);
+            ++requests;
+            bytes += length;
+            return std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0 && std::fread(out, 1, length, file) == length;
+        }
+
+        int requests = 0;
+        std::size_t bytes = 0;
+
+    private:
+        std::FILE* file;
+        std::chrono::milliseconds latency;
+        std::size_t file_size = 0;
+    };
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <pdf> [latency ms]\n", argv[0]);
+        return 1;
+    }
+    std::FILE* file = std::fopen(argv[1], "rb");
+    if (!file) {
+        std::fprintf(stderr, "can't open %s\n", argv[1]);
+        return 1;
+    }
+    std::chrono::milliseconds latency(argc > 2 ? std::atoi(argv[2]) : 5);
+
+    auto start = std::chrono::steady_clock::now();
+    auto source = std::make_unique<delayedFileSource>(file, latency);
+    delayedFileSource& counted = *source;
+    std::shared_ptr<document> doc = open(std::move(source));
+    if (!doc) {
+        std::fprintf(stderr, "%s isn't a readable PDF\n", argv[1]);
+        return 1;
+    }
+    page first_page = doc->get_page(0);
+    std::vector<textObject> text = first_page.parse_text_objects();
+    std::vector<imageObject> images = first_page.parse_page_images();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%s: %zu bytes, %d pages. page 1 (%zu text objects, %zu images) after %d requests, %zu bytes read, %.1f ms\n", argv[1],
+        counted.size(), doc->get_num_pages(), text.size(), images.size(), counted.requests, counted.bytes, ms);
+}
@@ -0,0 +1,118 @@
+/* text extraction throughput, in MB of decoded content stream per second, of page 1 of a document with a single content stream. the baseline
+is the Tj-only loop the content interpreter replaced, run over the same lexer, against parse_text_objects(), visit_text() & iterate_text().
+usage: bench_text_throughput <pdf> [runs] */
+#include "pdf_parser.cpp"
+#include <chrono>
+
+using namespace pdf_parser;
+
+namespace {
+    // the old page::parse_text_objects() loop: text objects with the first Td's coordinates & the raw strings of Tj, other operators skipped
+    std::vector<textObject> tj_only_text_objects(std::string_view content) {
+        std::vector<textObject> text_objs;
+        lexer lex(content);
+        std::vector<token> operands;
+        textObject obj;
+        bool in_text_obj = false;
+        bool has_coordinates = false;
+        for (token tok = lex.next(); tok.type != TOKEN_END; tok = lex.next()) {
+            if (tok.type != TOKEN_KEYWORD) {
+                operands.push_back(tok);
+                continue;
+            }
+            if (tok.text == "BT") {
+                obj = textObject{};
+                in_text_obj = true;
+                has_coordinates = false;
+            }
+            else if (tok.text == "ET" && in_text_obj) {
+                text_objs.push_back(obj);
+                in_text_obj = false;
+            }
+            else if (in_text_obj && tok.text == "Td" && operands.size() >= 2 && !has_coordinates) {
+                obj.text_coordinates = { operands[operands.size() - 2].real_value, operands.back().real_value };
+                has_coordinates = true;
+            }
+            else if (in_text_obj && tok.text == "Tf" && operands.size() >= 2 && operands[operands.size() - 2].type == TOKEN_NAME) {
+                textData text_block;
+                text_block.text_size = static_cast<int>(operands.back().real_value);
+                obj.text_blocks.push_back(text_block);
+            }
+            else if (in_text_obj && tok.text == "Tj" && !operands.empty() && operands.back().type == TOKEN_STRING && !obj.text_blocks.empty()) {
+                obj.text_blocks.back().text += operands.back().text;
+            }
+            operands.clear();
+        }
+        return text_objs;
+    }
+
+    std::size_t text_size(const std::vector<textObject>& text_objs) {
+        std::size_t size = 0;
+        for (const textObject& obj : text_objs) {
+            for (const textData& block : obj.text_blocks) size += block.text.size();
+        }
+        return size;
+    }
+
+    struct countingVisitor : textVisitor {
+        std::size_t size = 0;
+        void visit(const textRun& run) override { size += run.text.size(); }
+    };
+
+    // the fastest of runs calls to extract, which returns the size of the text it extracted
+    template <typename Extract>
+    void report(const char* name, int runs, std::size_t content_size, Extract extract) {
+        double best = 0;
+        std::size_t extracted = 0;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            extracted = extract();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (run == 0 || seconds < best) best = seconds;
+        }
+        std::printf("  %-22s %7.1f MB/s, %zu bytes of text\n", name, static_cast<double>(content_size) / best / 1e6, extracted);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <pdf> [runs]\n", argv[0]);
+        return 1;
+    }
+    int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    // the baseline needs the page's decoded content stream, which only the internal functions reach
+    docCore core;
+    if (!core.file.open(std::string(argv[1]), LOAD_MAPPED)) return 1;
+    core.doc_contents = core.file.view();
+    pageEntry entry;
+    if (!load_document(core) || !find_page(core, 0, entry)) return 1;
+    const pdfObject& contents = get_object(core, entry.ref).get("/Contents");
+    if (contents.type != OBJ_STREAM) {
+        std::fprintf(stderr, "page 1 of %s doesn't have a single content stream\n", argv[1]);
+        return 1;
+    }
+    std::string decoded;
+    decode_stream(contents, decoded);
+
+    std::shared_ptr<document> doc = open(argv[1]);
+    page first_page = doc->get_page(0);
+    std::printf("%s: %.1f MB content stream, best of %d runs\n", argv[1], decoded.size() / 1e6, runs);
+    // the baseline decodes the stream first, as the old loop did
+    report("Tj-only loop", runs, decoded.size(), [&] {
+        std::string content;
+        decode_stream(contents, content);
+        return text_size(tj_only_text_objects(content));
+    });
+    report("parse_text_objects()", runs, decoded.size(), [&] { return text_size(first_page.parse_text_objects()); });
+    report("visit_text()", runs, decoded.size(), [&] {
+        countingVisitor visitor;
+        first_page.visit_text(visitor);
+        return visitor.size;
+    });
+    report("iterate_text()", runs, decoded.size(), [&] {
+        std::size_t size = 0;
+        for (textRunIterator it = first_page.iterate_text(); it.next();) size += it->text.size();
+        return size;
+    });
+}
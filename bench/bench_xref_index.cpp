@@ -0,0 +1,41 @@
+/* xref lookups: xrefIndex against the nested std::map it replaced, looked up with operator[] as the parser used to. usage:
+    bench_xref_index [object count] [lookup count] */
+#include "pdf_parser.cpp"
+#include <chrono>
+#include <random>
+
+using namespace pdf_parser;
+
+int main(int argc, char** argv) {
+    int obj_count = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::size_t lookup_count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+    if (obj_count <= 0 || lookup_count == 0) return 1;
+
+    std::map<int, std::map<int, xrefEntry>> nested_map;
+    xrefIndex index;
+    index.reserve(static_cast<std::size_t>(obj_count));
+    for (int obj_num = 0; obj_num < obj_count; ++obj_num) {
+        xrefEntry entry{ static_cast<std::size_t>(obj_num) * 100, 0, 'n', 0, 0 };
+        nested_map[obj_num][0] = entry;
+        index.add(obj_num, entry);
+    }
+
+    // the same random object numbers for both
+    std::mt19937 rng(1);
+    std::vector<int> lookups(lookup_count);
+    for (int& obj_num : lookups) obj_num = static_cast<int>(rng() % static_cast<unsigned>(obj_count));
+
+    std::size_t checksum = 0; // keeps the lookups from being optimised away
+    auto start = std::chrono::steady_clock::now();
+    for (int obj_num : lookups) checksum += nested_map[obj_num][0].object_offset;
+    auto map_end = std::chrono::steady_clock::now();
+    for (int obj_num : lookups) {
+        xrefEntry entry;
+        if (index.find({ obj_num, 0 }, entry)) checksum += entry.object_offset;
+    }
+    auto index_end = std::chrono::steady_clock::now();
+
+    auto ns_per_lookup = [&](auto from, auto to) { return std::chrono::duration<double, std::nano>(to - from).count() / lookup_count; };
+    std::printf("%d objects, %zu lookups: std::map %.1f ns/lookup, xrefIndex %.1f ns/lookup (checksum %zu)\n", obj_count, lookup_count,
+        ns_per_lookup(start, map_end), ns_per_lookup(map_end, index_end), checksum);
+}
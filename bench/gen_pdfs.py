@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""writes the PDFs the benchmarks are run on. usage: gen_pdfs.py <kind> <output path> [size]
+
+    large   a 2 page document whose second page's content stream pads it out to size MB (default 1024), written
+            with the xref at the end, so only the first & last few KB are needed for page 1
+    text    one page of 300k text objects shown with Tj, about 19 MB of content stream
+    tj      one page of 300k text objects mixing TJ arrays, hex strings, escapes & Tj, about 29 MB of content stream
+"""
+import sys
+import zlib
+
+
+def stream(dict_entries, data, compress=True):
+    if compress:
+        data = zlib.compress(data)
+        dict_entries += b" /Filter /FlateDecode"
+    return b"<<" + dict_entries + b" /Length %d >>\nstream\n" % len(data) + data + b"\nendstream"
+
+
+class pdfWriter:
+    """writes numbered objects in order, then a classic xref & trailer for them"""
+
+    def __init__(self, out):
+        self.out = out
+        self.pos = 0
+        self.offsets = {}
+        self.write(b"%PDF-1.4\n%\xe2\xe3\xcf\xd3\n")
+
+    def write(self, data):
+        self.out.write(data)
+        self.pos += len(data)
+
+    def begin_object(self, num):
+        self.offsets[num] = self.pos
+        self.write(b"%d 0 obj\n" % num)
+
+    def add_object(self, num, body):
+        self.begin_object(num)
+        self.write(body + b"\nendobj\n")
+
+    def finish(self, root=1):
+        xref_pos = self.pos
+        size = max(self.offsets) + 1
+        self.write(b"xref\n0 %d\n0000000000 65535 f \n" % size)
+        for num in range(1, size):
+            if num in self.offsets:
+                self.write(b"%010d 00000 n \n" % self.offsets[num])
+            else:
+                self.write(b"0000000000 00000 f \n")
+        self.write(b"trailer\n<< /Size %d /Root %d 0 R >>\nstartxref\n%d\n%%%%EOF\n" % (size, root, xref_pos))
+
+
+def write_large(out, megabytes):
+    pdf = pdfWriter(out)
+    pdf.add_object(1, b"<< /Type /Catalog /Pages 2 0 R >>")
+    pdf.add_object(2, b"<< /Type /Pages /Kids [3 0 R 4 0 R] /Count 2 >>")
+    pdf.add_object(3, b"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 5 0 R >> >> /Contents 6 0 R >>")
+    pdf.add_object(4, b"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Contents 7 0 R >>")
+    pdf.add_object(5, b"<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>")
+    pdf.add_object(6, stream(b"", b"BT /F1 12 Tf 72 700 Td (First page) Tj ET\n"))
+    # a comment line of 1 MB at a time, uncompressed so the file really is that large
+    line = b"%" + b" " * ((1 << 20) - 2) + b"\n"
+    pdf.begin_object(7)
+    pdf.write(b"<< /Length %d >>\nstream\n" % (len(line) * megabytes))
+    for _ in range(megabytes):
+        pdf.write(line)
+    pdf.write(b"\nendstream\nendobj\n")
+    pdf.finish()
+
+
+def write_single_page(out, content):
+    pdf = pdfWriter(out)
+    pdf.add_object(1, b"<< /Type /Catalog /Pages 2 0 R >>")
+    pdf.add_object(2, b"<< /Type /Pages /Kids [3 0 R] /Count 1 >>")
+    pdf.add_object(3, b"<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] /Resources << /Font << /F1 4 0 R >> >> /Contents 5 0 R >>")
+    pdf.add_object(4, b"<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>")
+    pdf.add_object(5, stream(b"", content))
+    pdf.finish()
+
+
+def text_content():
+    return b"".join(b"BT /F1 %d Tf %d %d Td (word number %d here)Tj (more)Tj ET\n" % (8 + i % 3, i % 500, i % 700, i)
+                    for i in range(300000))
+
+
+def tj_content():
+    return b"".join(b"BT /F1 10 Tf %d %d Td [(Wo) 30 (rd) -250 (n\\(%d\\)) -250 <48656c6c6f>] TJ (tail %d)Tj ET\n" % (i % 500, i % 700, i, i)
+                    for i in range(300000))
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    kind, path = sys.argv[1], sys.argv[2]
+    with open(path, "wb") as out:
+        if kind == "large":
+            write_large(out, int(sys.argv[3]) if len(sys.argv) > 3 else 1024)
+        elif kind == "text":
+            write_single_page(out, text_content())
+        elif kind == "tj":
+            write_single_page(out, tj_content())
+        else:
+            sys.exit(__doc__)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,27 +1,894 @@
 #include "pdf_parser.hpp"
 
+#if defined(__unix__) || defined(__APPLE__)
+#define PDF_PARSER_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// the PNG predictor kernels have SSE2 & AVX2 versions, selected at runtime
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PDF_PARSER_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
 namespace pdf_parser {
 
-    /* struct definitions not exposed to API */
+    /* PDF lexer. splits a span of the document into typed tokens in a single forward pass, without copying: every token's text is a view into
+    the lexed span. used for all dictionary, array & ref parsing & for content streams */
+
+    enum tokenType : int {
+        TOKEN_END, // end of the span
+        TOKEN_INTEGER,
+        TOKEN_REAL,
+        TOKEN_NAME, // text includes the leading '/', like the tags passed to the parse functions
+        TOKEN_STRING, // literal string, text is the raw bytes between the outer parentheses, escapes aren't decoded
+        TOKEN_HEX_STRING, // text is the hex digits between < & >
+        TOKEN_ARRAY_BEGIN,
+        TOKEN_ARRAY_END,
+        TOKEN_DICT_BEGIN,
+        TOKEN_DICT_END,
+        TOKEN_REF, // '<obj num> <gen num> R', read as one token
+        TOKEN_KEYWORD // everything else: true, false, null, obj, endobj, stream & content stream operators
+    };
+
+    struct token {
+        tokenType type;
+        std::string_view text;
+        long long int_value; // for TOKEN_INTEGER
+        double real_value; // for TOKEN_INTEGER & TOKEN_REAL
+        objectRef ref; // for TOKEN_REF
+        std::size_t pos; // offset of the token in the lexed span
+    };
+
+    // the lexer's character classes, looked up in a table as they are checked for every byte lexed
+    enum charClass : uint8_t {
+        CHAR_REGULAR,
+        CHAR_WHITESPACE,
+        CHAR_DELIMITER
+    };
+
+    constexpr std::array<uint8_t, 256> make_char_classes() {
+        std::array<uint8_t, 256> classes{};
+        for (char c : std::string_view(" \n\r\t\f\0", 6)) classes[static_cast<unsigned char>(c)] = CHAR_WHITESPACE;
+        for (char c : std::string_view("()<>[]{}/%")) classes[static_cast<unsigned char>(c)] = CHAR_DELIMITER;
+        return classes;
+    }
+
+    constexpr std::array<uint8_t, 256> char_classes = make_char_classes();
+
+    bool is_pdf_whitespace(char c) {
+        return char_classes[static_cast<unsigned char>(c)] == CHAR_WHITESPACE;
+    }
+
+    bool is_pdf_delimiter(char c) {
+        return char_classes[static_cast<unsigned char>(c)] == CHAR_DELIMITER;
+    }
+
+    bool is_pdf_regular(char c) {
+        return char_classes[static_cast<unsigned char>(c)] == CHAR_REGULAR;
+    }
+
+    class lexer {
+    public:
+        // content streams have no refs, so their lexers don't look for them after every integer
+        explicit lexer(std::string_view data, std::size_t pos = 0, bool match_refs = true) : data(data), pos(pos), match_refs(match_refs) {}
+
+        token next() {
+            token tok = next_raw();
+            if (match_refs && tok.type == TOKEN_INTEGER && tok.int_value >= 0) match_ref(tok);
+            return tok;
+        }
+
+        token peek() {
+            std::size_t saved_pos = pos;
+            token tok = next();
+            pos = saved_pos;
+            return tok;
+        }
+
+        // skips one complete value, including everything inside arrays & dictionaries
+        void skip_value() {
+            token tok = next();
+            if (tok.type == TOKEN_ARRAY_BEGIN || tok.type == TOKEN_DICT_BEGIN) skip_container();
+        }
+
+        // skips to past the ']' or '>>' matching an array or dictionary start which has just been read
+        void skip_container() {
+            int depth = 1;
+            while (depth > 0) {
+                token tok = next_raw();
+                if (tok.type == TOKEN_END) return;
+                if (tok.type == TOKEN_ARRAY_BEGIN || tok.type == TOKEN_DICT_BEGIN) ++depth;
+                if (tok.type == TOKEN_ARRAY_END || tok.type == TOKEN_DICT_END) --depth;
+            }
+        }
+
+        std::size_t position() const { return pos; }
+        void seek(std::size_t new_pos) { pos = new_pos; }
+        std::string_view span() const { return data; }
+
+    private:
+        void skip_whitespace() {
+            while (pos < data.size()) {
+                char c = data[pos];
+                if (is_pdf_whitespace(c)) ++pos;
+                else if (c == '%') { // comments run to the end of the line
+                    while (pos < data.size() && data[pos] != '\n' && data[pos] != '\r') ++pos;
+                }
+                else break;
+            }
+        }
+
+        token make_token(tokenType type, std::size_t start) {
+            token tok{};
+            tok.type = type;
+            tok.text = data.substr(start, pos - start);
+            tok.pos = start;
+            return tok;
+        }
+
+        token next_raw() {
+            skip_whitespace();
+            std::size_t start = pos;
+            if (pos >= data.size()) return make_token(TOKEN_END, start);
+
+            char c = data[pos];
+            switch (c) {
+            case '/':
+                ++pos;
+                while (pos < data.size() && is_pdf_regular(data[pos])) ++pos;
+                return make_token(TOKEN_NAME, start);
+            case '(': {
+                // strings may contain balanced parentheses & escaped ones, which don't count towards the nesting
+                int depth = 1;
+                ++pos;
+                while (pos < data.size() && depth > 0) {
+                    char s = data[pos++];
+                    if (s == '\\') ++pos;
+                    else if (s == '(') ++depth;
+                    else if (s == ')') --depth;
+                }
+                pos = std::min(pos, data.size());
+                token tok = make_token(TOKEN_STRING, start);
+                tok.text = data.substr(start + 1, pos - start - (depth == 0 ? 2 : 1));
+                return tok;
+            }
+            case '<':
+                if (pos + 1 < data.size() && data[pos + 1] == '<') {
+                    pos += 2;
+                    return make_token(TOKEN_DICT_BEGIN, start);
+                }
+                else {
+                    std::size_t hex_end = data.find('>', pos);
+                    pos = hex_end == std::string_view::npos ? data.size() : hex_end + 1;
+                    token tok = make_token(TOKEN_HEX_STRING, start);
+                    tok.text = data.substr(start + 1, (hex_end == std::string_view::npos ? data.size() : hex_end) - start - 1);
+                    return tok;
+                }
+            case '>':
+                if (pos + 1 < data.size() && data[pos + 1] == '>') {
+                    pos += 2;
+                    return make_token(TOKEN_DICT_END, start);
+                }
+                ++pos;
+                return make_token(TOKEN_KEYWORD, start); // stray '>', left to the caller to reject
+            case '[':
+                ++pos;
+                return make_token(TOKEN_ARRAY_BEGIN, start);
+            case ']':
+                ++pos;
+                return make_token(TOKEN_ARRAY_END, start);
+            case '{':
+            case '}':
+            case ')':
+                ++pos;
+                return make_token(TOKEN_KEYWORD, start);
+            default:
+                break;
+            }
+
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '+' || c == '-' || c == '.') return read_number();
+
+            while (pos < data.size() && is_pdf_regular(data[pos])) ++pos;
+            return make_token(TOKEN_KEYWORD, start);
+        }
+
+        // PDF numbers have no exponent, so they are read by hand instead of with strtod (the span isn't null terminated)
+        token read_number() {
+            std::size_t start = pos;
+            bool negative = false;
+            if (data[pos] == '+' || data[pos] == '-') negative = data[pos++] == '-';
+
+            long long int_part = 0;
+            bool has_digits = false;
+            while (pos < data.size() && std::isdigit(static_cast<unsigned char>(data[pos]))) {
+                int_part = int_part * 10 + (data[pos++] - '0');
+                has_digits = true;
+            }
+
+            double real = static_cast<double>(int_part);
+            bool is_real = false;
+            if (pos < data.size() && data[pos] == '.') {
+                is_real = true;
+                ++pos;
+                double scale = 0.1;
+                while (pos < data.size() && std::isdigit(static_cast<unsigned char>(data[pos]))) {
+                    real += (data[pos++] - '0') * scale;
+                    scale *= 0.1;
+                    has_digits = true;
+                }
+            }
+            // anything else glued to the number makes it a keyword (e.g. operators in damaged streams)
+            if (!has_digits || (pos < data.size() && is_pdf_regular(data[pos]))) {
+                while (pos < data.size() && is_pdf_regular(data[pos])) ++pos;
+                return make_token(TOKEN_KEYWORD, start);
+            }
+
+            token tok = make_token(is_real ? TOKEN_REAL : TOKEN_INTEGER, start);
+            tok.int_value = negative ? -int_part : int_part;
+            tok.real_value = negative ? -real : real;
+            return tok;
+        }
+
+        /* an integer followed by '<gen num> R' is a ref. checked with a cheap look ahead over the raw bytes so runs of plain numbers (arrays,
+        content stream operands) aren't lexed more than once */
+        void match_ref(token& tok) {
+            std::size_t look = pos;
+            auto skip_ws = [this, &look]() { while (look < data.size() && is_pdf_whitespace(data[look])) ++look; };
+
+            skip_ws();
+            if (look == pos || look >= data.size() || !std::isdigit(static_cast<unsigned char>(data[look]))) return;
+            long long gen_num = 0;
+            while (look < data.size() && std::isdigit(static_cast<unsigned char>(data[look]))) gen_num = gen_num * 10 + (data[look++] - '0');
+            std::size_t gen_end = look;
+            skip_ws();
+            if (look == gen_end || look >= data.size() || data[look] != 'R') return;
+            if (look + 1 < data.size() && is_pdf_regular(data[look + 1])) return;
+
+            pos = look + 1;
+            tok.type = TOKEN_REF;
+            tok.ref = { static_cast<int>(tok.int_value), static_cast<int>(gen_num) };
+            tok.text = data.substr(tok.pos, pos - tok.pos);
+        }
+
+        std::string_view data;
+        std::size_t pos;
+        bool match_refs;
+    };
+
+    bool is_keyword(const token& tok, std::string_view keyword) {
+        return tok.type == TOKEN_KEYWORD && tok.text == keyword;
+    }
+
+    bool is_number(const token& tok) {
+        return tok.type == TOKEN_INTEGER || tok.type == TOKEN_REAL;
+    }
+
+    /* string decoding. the lexer leaves strings as they are written, these decode them onto the end of out so that e.g. the strings of a TJ
+    array can be decoded into one buffer */
+
+    int hex_digit_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // whitespace between the digits is ignored & an odd final digit is followed by an implicit 0
+    void decode_hex_string(std::string_view hex, std::string& out) {
+        int high_nibble = -1;
+        for (char c : hex) {
+            int nibble = hex_digit_value(c);
+            if (nibble < 0) continue;
+            if (high_nibble < 0) high_nibble = nibble;
+            else {
+                out += static_cast<char>(high_nibble << 4 | nibble);
+                high_nibble = -1;
+            }
+        }
+        if (high_nibble >= 0) out += static_cast<char>(high_nibble << 4);
+    }
+
+    // whether a literal string has escapes or end of line markers to decode, most don't & can be used as they are
+    bool needs_decoding(std::string_view raw) {
+        return raw.find_first_of("\\\r") != std::string_view::npos;
+    }
+
+    /* decodes a literal string's escapes: \n \r \t \b \f, escaped parentheses & backslashes, 1-3 digit octal codes & a backslash before an end of
+    line, which continues the string on the next line. unknown escapes are dropped, leaving the character after them, & unescaped ends of
+    line (\r or \r\n) are read as \n */
+    void decode_literal_string(std::string_view raw, std::string& out) {
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            char c = raw[i];
+            if (c == '\r') {
+                out += '\n';
+                if (i + 1 < raw.size() && raw[i + 1] == '\n') ++i;
+                continue;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (++i == raw.size()) break;
+            c = raw[i];
+            switch (c) {
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case '\r': // line continuation
+                if (i + 1 < raw.size() && raw[i + 1] == '\n') ++i;
+                break;
+            case '\n':
+                break;
+            default:
+                if (c >= '0' && c <= '7') {
+                    int code = c - '0';
+                    for (int digits = 1; digits < 3 && i + 1 < raw.size() && raw[i + 1] >= '0' && raw[i + 1] <= '7'; ++digits) code = code * 8 + (raw[++i] - '0');
+                    out += static_cast<char>(code & 0xFF); // codes over 255 overflow, as in other readers
+                }
+                else out += c; // \(, \), \\ & unknown escapes
+                break;
+            }
+        }
+    }
+
+    /* PDF object model. objects are parsed once into a pdfObject tree whose names & strings are views into the document (or into an inflated
+    /ObjStm), dictionaries are kept sorted by key so lookups are a binary search instead of a rescan of the object's text */
+
+    enum objectType : int {
+        OBJ_NULL,
+        OBJ_BOOL,
+        OBJ_INTEGER,
+        OBJ_REAL,
+        OBJ_NAME,
+        OBJ_STRING,
+        OBJ_ARRAY,
+        OBJ_DICT,
+        OBJ_REF,
+        OBJ_STREAM // a dictionary followed by stream data
+    };
+
+    struct dictEntry;
+
+    struct pdfObject {
+        objectType type = OBJ_NULL;
+        bool bool_value = false;
+        long long int_value = 0;
+        double real_value = 0; // set for both integers & reals
+        std::string_view text; // names (including the '/') & strings (raw bytes, escapes aren't decoded)
+        bool is_hex = false; // for strings written as <hex>
+        objectRef ref{-1, 0};
+        docCore* doc = nullptr; // for refs, the document they are resolved in
+        std::vector<pdfObject> array;
+        std::vector<dictEntry> dict; // for dicts & streams, sorted by key
+        std::string_view stream_data; // for streams, the raw (still encoded) data
+
+        bool is_dict() const { return type == OBJ_DICT || type == OBJ_STREAM; }
+        bool is_number() const { return type == OBJ_INTEGER || type == OBJ_REAL; }
+
+        const pdfObject* find(std::string_view key) const; // the value under key as written, refs aren't followed
+        const pdfObject& get(std::string_view key) const; // the value under key with refs resolved, a null object when missing
+
+        long long get_int(std::string_view key, long long default_value = 0) const;
+        double get_number(std::string_view key, double default_value = 0) const;
+        bool get_bool(std::string_view key, bool default_value = false) const;
+        std::string_view get_name(std::string_view key) const; // including the '/', empty when missing or not a name
+    };
+
+    struct dictEntry {
+        std::string_view key; // including the '/'
+        pdfObject value;
+    };
+
+    const pdfObject null_object{};
+
+    const pdfObject& get_object(docCore& doc, objectRef ref);
+
+    // follows obj if it is a ref, so direct & indirect values can be read the same way
+    const pdfObject& resolve(const pdfObject& obj) {
+        return obj.type == OBJ_REF && obj.doc ? get_object(*obj.doc, obj.ref) : obj;
+    }
+
+    const pdfObject* pdfObject::find(std::string_view key) const {
+        auto entry_iter = std::lower_bound(dict.begin(), dict.end(), key, [](const dictEntry& entry, std::string_view k) { return entry.key < k; });
+        if (entry_iter == dict.end() || entry_iter->key != key) return nullptr;
+        return &entry_iter->value;
+    }
+
+    const pdfObject& pdfObject::get(std::string_view key) const {
+        const pdfObject* value = find(key);
+        return value ? resolve(*value) : null_object;
+    }
+
+    long long pdfObject::get_int(std::string_view key, long long default_value) const {
+        const pdfObject& value = get(key);
+        if (value.type == OBJ_INTEGER) return value.int_value;
+        if (value.type == OBJ_REAL) return static_cast<long long>(value.real_value);
+        return default_value;
+    }
+
+    double pdfObject::get_number(std::string_view key, double default_value) const {
+        const pdfObject& value = get(key);
+        return value.is_number() ? value.real_value : default_value;
+    }
+
+    bool pdfObject::get_bool(std::string_view key, bool default_value) const {
+        const pdfObject& value = get(key);
+        return value.type == OBJ_BOOL ? value.bool_value : default_value;
+    }
+
+    std::string_view pdfObject::get_name(std::string_view key) const {
+        const pdfObject& value = get(key);
+        return value.type == OBJ_NAME ? value.text : std::string_view();
+    }
+
+    // parses the next value from lex, arrays & dictionaries recursively
+    pdfObject parse_object(lexer& lex, docCore* doc, int depth = 0) {
+        const int max_depth = 64; // stops damaged or malicious nesting from exhausting the stack
+        pdfObject obj;
+        token tok = lex.next();
+
+        switch (tok.type) {
+        case TOKEN_INTEGER:
+            obj.type = OBJ_INTEGER;
+            obj.int_value = tok.int_value;
+            obj.real_value = tok.real_value;
+            break;
+        case TOKEN_REAL:
+            obj.type = OBJ_REAL;
+            obj.int_value = static_cast<long long>(tok.real_value);
+            obj.real_value = tok.real_value;
+            break;
+        case TOKEN_NAME:
+            obj.type = OBJ_NAME;
+            obj.text = tok.text;
+            break;
+        case TOKEN_STRING:
+        case TOKEN_HEX_STRING:
+            obj.type = OBJ_STRING;
+            obj.text = tok.text;
+            obj.is_hex = tok.type == TOKEN_HEX_STRING;
+            break;
+        case TOKEN_REF:
+            obj.type = OBJ_REF;
+            obj.ref = tok.ref;
+            obj.doc = doc;
+            break;
+        case TOKEN_ARRAY_BEGIN:
+            obj.type = OBJ_ARRAY;
+            if (depth >= max_depth) {
+                lex.skip_container(); // nested too deeply, read as an empty array so its contents don't spill into the parent
+                break;
+            }
+            while (true) {
+                token next = lex.peek();
+                if (next.type == TOKEN_END) break;
+                if (next.type == TOKEN_ARRAY_END) {
+                    lex.next();
+                    break;
+                }
+                obj.array.push_back(parse_object(lex, doc, depth + 1));
+            }
+            break;
+        case TOKEN_DICT_BEGIN:
+            obj.type = OBJ_DICT;
+            if (depth >= max_depth) {
+                lex.skip_container();
+                break;
+            }
+            while (true) {
+                token key = lex.next();
+                if (key.type == TOKEN_END || key.type == TOKEN_DICT_END) break;
+                if (key.type != TOKEN_NAME) continue; // junk where a key should be, skip it
+                if (lex.peek().type == TOKEN_DICT_END) { // key without a value, the '>>' still ends this dictionary
+                    lex.next();
+                    break;
+                }
+                obj.dict.push_back({ key.text, parse_object(lex, doc, depth + 1) });
+            }
+            // stable, so when a key is repeated the first one written is found
+            std::stable_sort(obj.dict.begin(), obj.dict.end(), [](const dictEntry& a, const dictEntry& b) { return a.key < b.key; });
+            break;
+        case TOKEN_KEYWORD:
+            if (tok.text == "true" || tok.text == "false") {
+                obj.type = OBJ_BOOL;
+                obj.bool_value = tok.text == "true";
+            }
+            break; // null & anything unexpected read as null
+        default:
+            break;
+        }
+        return obj;
+    }
+
+    // skips the '<obj num> <gen num> obj' header objects have when they aren't stored in an /ObjStm
+    void skip_object_header(lexer& lex) {
+        std::size_t start = lex.position();
+        if (lex.next().type == TOKEN_INTEGER && lex.next().type == TOKEN_INTEGER && is_keyword(lex.next(), "obj")) return;
+        lex.seek(start);
+    }
+
+    /* returns the bytes between the 'stream' keyword (ending at data_start) & 'endstream'. the extent comes from /Length, which is trusted when
+    'endstream' follows it. when the length is missing or wrong (damaged files), the data is scanned for 'endstream' instead */
+    std::string_view read_stream_data(std::string_view data, std::size_t data_start, long long length) {
+        // the keyword is followed by CRLF or LF, the data by an EOL & endstream
+        if (data_start < data.size() && data[data_start] == '\r') ++data_start;
+        if (data_start < data.size() && data[data_start] == '\n') ++data_start;
+
+        if (length >= 0 && static_cast<unsigned long long>(length) <= data.size() - data_start) {
+            std::size_t data_end = data_start + static_cast<std::size_t>(length);
+            std::size_t pos = data_end;
+            while (pos < data.size() && pos - data_end < 32 && std::isspace(static_cast<unsigned char>(data[pos]))) ++pos;
+            if (data.compare(pos, 9, "endstream") == 0) return data.substr(data_start, static_cast<std::size_t>(length));
+        }
+
+        std::size_t data_end = data.find("endstream", data_start);
+        if (data_end == std::string_view::npos) data_end = data.size();
+        if (data_end > data_start && data[data_end - 1] == '\n') --data_end;
+        if (data_end > data_start && data[data_end - 1] == '\r') --data_end;
+        return data.substr(data_start, data_end - data_start);
+    }
+
+    // serves LOAD_ON_DEMAND documents, reading the ranges the parser asks for from the file
+    class fileSource : public byteSource {
+    public:
+        bool open(const std::string& path) {
+            file.open(path, std::ios::binary | std::ios::ate);
+            if (!file) return false;
+            file_size = static_cast<std::size_t>(file.tellg());
+            return true;
+        }
+
+        std::size_t size() override { return file_size; }
+
+        bool read(std::size_t offset, std::size_t length, char* out) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            file.clear();
+            file.seekg(static_cast<std::streamoff>(offset));
+            file.read(out, static_cast<std::streamsize>(length));
+            return static_cast<std::size_t>(file.gcount()) == length;
+        }
+
+    private:
+        std::ifstream file;
+        std::size_t file_size = 0;
+        std::mutex mutex;
+    };
+
+    /* read-only backing storage for an opened document. with LOAD_MAPPED the file is memory mapped, so its bytes are paged in by the OS as the parser
+    touches them & are never copied onto the heap. LOAD_BUFFERED (or platforms without mmap) read the file once straight into an owned buffer.
+    documents opened from a byteSource (& LOAD_ON_DEMAND) are only partly available: storage for the whole file is reserved up front but only the
+    chunks the parser asks for through ensure() are read into it, so the parser has to fetch a range before it reads it, see fetch() */
+    class mappedFile {
+    public:
+        static constexpr std::size_t chunk_size = 16384; // the smallest range requested from a source
+
+        mappedFile() = default;
+        mappedFile(const mappedFile&) = delete;
+        mappedFile& operator=(const mappedFile&) = delete;
+        ~mappedFile() { close(); }
+
+        bool open(std::unique_ptr<byteSource> new_source) {
+            close();
+            if (!new_source) return false;
+            std::size_t source_size = new_source->size();
+            if (source_size == 0) return false;
+#ifdef PDF_PARSER_HAS_MMAP
+            // only reserves address space, memory is committed as chunks are read into it
+            void* addr = mmap(nullptr, source_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (addr == MAP_FAILED) return false;
+            data = static_cast<char*>(addr);
+            mapped = true;
+#else
+            buffer.resize(source_size);
+            data = buffer.data();
+#endif
+            size = source_size;
+            source = std::move(new_source);
+            chunk_loaded.assign((size + chunk_size - 1) / chunk_size, false);
+            return true;
+        }
+
+        // a document held in the caller's memory, which has to outlive it. nothing is copied
+        bool open(const char* borrowed_data, std::size_t borrowed_size) {
+            close();
+            if (!borrowed_data || borrowed_size == 0) return false;
+            data = const_cast<char*>(borrowed_data); // never written, only sources write into data
+            size = borrowed_size;
+            return true;
+        }
+
+        bool open(const std::string& path, loadMode mode) {
+            close();
+#ifdef PDF_PARSER_HAS_MMAP
+            if (mode == LOAD_MAPPED) {
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) return false;
+                struct stat st{};
+                if (fstat(fd, &st) != 0) {
+                    ::close(fd);
+                    return false;
+                }
+                if (st.st_size > 0) {
+                    void* addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (addr != MAP_FAILED) {
+                        ::close(fd); // the mapping keeps its own reference to the file
+                        data = static_cast<char*>(addr);
+                        size = static_cast<std::size_t>(st.st_size);
+                        mapped = true;
+                        return true;
+                    }
+                }
+                ::close(fd); // empty file or mmap failure, fall through to the buffered read
+            }
+#endif
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file) return false;
+            buffer.resize(static_cast<std::size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            data = buffer.data();
+            size = buffer.size();
+            return true;
+        }
+
+        void close() {
+#ifdef PDF_PARSER_HAS_MMAP
+            if (mapped) munmap(data, size);
+#endif
+            mapped = false;
+            data = nullptr;
+            size = 0;
+            buffer.clear();
+            buffer.shrink_to_fit();
+            source.reset();
+            chunk_loaded.clear();
+            bytes_read = 0;
+        }
+
+        std::string_view view() const { return std::string_view(data, size); }
+
+        // false while the document comes from a source & may still have bytes which haven't been read
+        bool complete() const { return !source; }
+
+        /* reads the chunks of [offset, offset + length) which haven't been read yet from the source, each run of missing chunks with one request.
+        returns false if the source failed, leaving those chunks unread. does nothing for complete documents */
+        bool ensure(std::size_t offset, std::size_t length) {
+            if (!source || offset >= size || length == 0) return true;
+            std::size_t end = length > size - offset ? size : offset + length;
+            std::lock_guard<std::mutex> lock(fetch_mutex);
+            std::size_t chunk = offset / chunk_size;
+            std::size_t last_chunk = (end - 1) / chunk_size;
+            while (chunk <= last_chunk) {
+                if (chunk_loaded[chunk]) {
+                    ++chunk;
+                    continue;
+                }
+                std::size_t run_end = chunk;
+                while (run_end <= last_chunk && !chunk_loaded[run_end]) ++run_end;
+                std::size_t read_offset = chunk * chunk_size;
+                std::size_t read_length = std::min(size, run_end * chunk_size) - read_offset;
+                if (!source->read(read_offset, read_length, data + read_offset)) return false;
+                std::fill(chunk_loaded.begin() + chunk, chunk_loaded.begin() + run_end, true);
+                bytes_read += read_length;
+                chunk = run_end;
+            }
+            return true;
+        }
+
+        // bytes read from the source so far, all of them for complete documents
+        std::size_t get_bytes_read() {
+            if (!source) return size;
+            std::lock_guard<std::mutex> lock(fetch_mutex);
+            return bytes_read;
+        }
 
-    // used to store deflated (or compressed) objects' refs in an xrefStream for parsing in parse_xref_stream()
-    struct deflatedObjRef {
-        int index;
-        std::size_t line_start;
-        std::size_t line_end;
+    private:
+        char* data = nullptr;
+        std::size_t size = 0;
+        bool mapped = false;
+        std::string buffer; // only holds the document for LOAD_BUFFERED reads
+        // for documents read from a source
+        std::unique_ptr<byteSource> source;
+        std::vector<bool> chunk_loaded;
+        std::size_t bytes_read = 0;
+        std::mutex fetch_mutex; // guards chunk_loaded, pages parsed on different threads can fetch at once
     };
 
+    /* struct definitions not exposed to API */
+
     struct xrefEntry {
 		std::size_t object_offset;
 		int gen_num;
-		char status;
+		char status; // 'n' in use, 'f' free, 'c' compressed into an /ObjStm
+		int obj_stm_num; // for compressed objects only, the object number of the /ObjStm holding the object
+		int obj_stm_index; // for compressed objects only, the object's index within that /ObjStm
 	};
 
-    /* used in other structs to store obj & gen num of specific refrenced objects */
-	struct objectRef {
-		int obj_num;
-		int gen_num;
-	};
+    /* the sidecar index (see write_index()) is a sequence of fixed-width little-endian 64-bit fields, written byte by byte so the format doesn't
+    depend on the machine's byte order */
+    void append_u64(std::string& out, uint64_t value) {
+        for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    // reads the fields append_u64() wrote. once a read runs past the end, it & every later read fail
+    class indexReader {
+    public:
+        explicit indexReader(std::string_view data) : data(data) {}
+
+        bool read(uint64_t& value) {
+            if (failed || data.size() - pos < 8) {
+                failed = true;
+                return false;
+            }
+            value = 0;
+            for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(static_cast<uint8_t>(data[pos + i])) << (8 * i);
+            pos += 8;
+            return true;
+        }
+
+        bool read_bytes(std::size_t length, std::string_view& bytes) {
+            if (failed || data.size() - pos < length) {
+                failed = true;
+                return false;
+            }
+            bytes = data.substr(pos, length);
+            pos += length;
+            return true;
+        }
+
+        // reads a count of items, each at least item_size bytes, failing if the rest of the data can't hold them
+        bool read_count(std::size_t item_size, std::size_t& count) {
+            uint64_t value = 0;
+            if (!read(value) || value > (data.size() - pos) / item_size) {
+                failed = true;
+                return false;
+            }
+            count = static_cast<std::size_t>(value);
+            return true;
+        }
+
+        bool ok() const { return !failed; }
+
+    private:
+        std::string_view data;
+        std::size_t pos = 0;
+        bool failed = false;
+    };
+
+    /* the document's xref, indexed by object number. every object's entry is packed into 8 bytes of a dense array: the top 3 bits hold the entry's
+    type & the rest the object's byte offset, or for compressed objects its /ObjStm number & index. in-use objects with a gen number other than 0
+    are rare (only reused object numbers have them) so they are kept in a small side table, their dense slot only marking that they live there.
+    lookups are O(1) & never modify the index */
+    class xrefIndex {
+    public:
+        // the PDF spec's implementation limit on indirect objects, stops damaged xrefs from allocating huge tables
+        static constexpr int max_objects = 8388608;
+
+        void clear() {
+            entries.clear();
+            other_gen_entries.clear();
+        }
+
+        void reserve(std::size_t obj_count) {
+            if (obj_count <= static_cast<std::size_t>(max_objects) && obj_count > entries.size()) entries.resize(obj_count, 0);
+        }
+
+        /* adds the entry for obj_num unless the object already has one. xref sections are read newest first, so an object already in the index comes
+        from a newer section & the older entry is ignored */
+        void add(int obj_num, const xrefEntry& entry) {
+            if (obj_num < 0 || obj_num >= max_objects) return;
+            if (static_cast<std::size_t>(obj_num) >= entries.size()) entries.resize(static_cast<std::size_t>(obj_num) + 1, 0);
+            uint64_t& slot = entries[obj_num];
+            if (slot != 0) return;
+
+            switch (entry.status) {
+            case 'n':
+                if (entry.gen_num != 0) {
+                    slot = pack(ENTRY_OTHER_GEN, 0);
+                    other_gen_entries.emplace(obj_num, entry);
+                }
+                else slot = pack(ENTRY_IN_USE, entry.object_offset);
+                break;
+            case 'c':
+                slot = pack(ENTRY_COMPRESSED, (static_cast<uint64_t>(entry.obj_stm_num) << index_bits) | (static_cast<uint64_t>(entry.obj_stm_index) & index_mask));
+                break;
+            default: // free objects only need to hide older entries for the same number
+                slot = pack(ENTRY_FREE, 0);
+                break;
+            }
+        }
+
+        // looks up the entry for ref, returns false if the object is missing, free or has a different gen number
+        bool find(objectRef ref, xrefEntry& entry) const {
+            if (ref.obj_num < 0 || static_cast<std::size_t>(ref.obj_num) >= entries.size()) return false;
+            uint64_t slot = entries[ref.obj_num];
+            uint64_t value = slot & value_mask;
+
+            switch (slot >> type_shift) {
+            case ENTRY_IN_USE:
+                if (ref.gen_num != 0) return false;
+                entry = { static_cast<std::size_t>(value), 0, 'n', 0, 0 };
+                return true;
+            case ENTRY_COMPRESSED:
+                if (ref.gen_num != 0) return false;
+                entry = { 0, 0, 'c', static_cast<int>(value >> index_bits), static_cast<int>(value & index_mask) };
+                return true;
+            case ENTRY_OTHER_GEN: {
+                auto gen_iter = other_gen_entries.find(ref.obj_num);
+                if (gen_iter == other_gen_entries.end() || gen_iter->second.gen_num != ref.gen_num) return false;
+                entry = gen_iter->second;
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        std::size_t size() const { return entries.size(); }
+
+        // appends the index to a sidecar index, the packed entries as they are
+        void write(std::string& out) const {
+            append_u64(out, entries.size());
+            for (uint64_t slot : entries) append_u64(out, slot);
+            append_u64(out, other_gen_entries.size());
+            for (const auto& [obj_num, entry] : other_gen_entries) {
+                append_u64(out, static_cast<uint64_t>(obj_num));
+                append_u64(out, entry.object_offset);
+                append_u64(out, static_cast<uint64_t>(entry.gen_num));
+            }
+        }
+
+        // reads what write() wrote into an empty index, returns false if it is malformed
+        bool read(indexReader& in) {
+            std::size_t entry_count = 0;
+            if (!in.read_count(8, entry_count) || entry_count > static_cast<std::size_t>(max_objects)) return false;
+            entries.resize(entry_count);
+            for (uint64_t& slot : entries) in.read(slot);
+
+            std::size_t other_gen_count = 0;
+            if (!in.read_count(24, other_gen_count)) return false;
+            for (std::size_t i = 0; i < other_gen_count; ++i) {
+                uint64_t obj_num = 0, offset = 0, gen_num = 0;
+                if (!in.read(obj_num) || !in.read(offset) || !in.read(gen_num) || obj_num >= entry_count) return false;
+                other_gen_entries.emplace(static_cast<int>(obj_num), xrefEntry{ static_cast<std::size_t>(offset), static_cast<int>(gen_num), 'n', 0, 0 });
+            }
+            return in.ok();
+        }
+
+    private:
+        enum entryType : uint64_t {
+            ENTRY_UNSET, // 0, so a freshly resized array holds no entries
+            ENTRY_FREE,
+            ENTRY_IN_USE,
+            ENTRY_COMPRESSED,
+            ENTRY_OTHER_GEN
+        };
+
+        static constexpr int type_shift = 61;
+        static constexpr uint64_t value_mask = (uint64_t(1) << type_shift) - 1;
+        static constexpr int index_bits = 30; // a compressed object's index, the /ObjStm number takes the bits above it
+        static constexpr uint64_t index_mask = (uint64_t(1) << index_bits) - 1;
+
+        static uint64_t pack(entryType type, uint64_t value) {
+            return (static_cast<uint64_t>(type) << type_shift) | (value & value_mask);
+        }
+
+        std::vector<uint64_t> entries;
+        std::unordered_map<int, xrefEntry> other_gen_entries;
+    };
+
+    // a decompressed /ObjStm, inflated the first time one of its objects is requested & kept so later lookups are just an offset lookup
+    struct objectStream {
+        std::string contents; // the inflated stream
+        std::vector<int> obj_nums; // object number at each index of the stream
+        std::vector<std::size_t> obj_offsets; // offset of each object by its index, already adjusted by /First
+    };
     
     // PDFs can either store essential ref data in trailers (since PDF 1.0) or xrefStreams (since 1.5) this base allows both options to derive from a common parent
     struct refStruct {
@@ -34,10 +901,7 @@ namespace pdf_parser {
     };
 
     struct xrefStreamInfo {
-        streamPredictor predictor;
-        int columns; // used only when a predictor is used
-        streamFilter filter;
-        std::array<int, 2> index; // key-value pair in xrefStreams that represents starting object & amount of objects stored
+        std::vector<std::array<int, 2>> index; // one key-value pair per subsection, the starting object & amount of objects stored
         std::array<int, 3> width;
     };
 
@@ -47,781 +911,3245 @@ namespace pdf_parser {
 	};
     
 
+    /* a leaf of the page tree. /Resources, /MediaBox, /CropBox & /Rotate can be set on any node & are inherited by the pages below it, here they
+    are already resolved to the nearest value. they point into the document's object cache, or are the null object when no node sets them */
+    struct pageEntry {
+        objectRef ref{-1, 0};
+        const pdfObject* resources = &null_object;
+        const pdfObject* media_box = &null_object;
+        const pdfObject* crop_box = &null_object;
+        const pdfObject* rotate = &null_object;
+    };
+
 	// holds root object
 	struct objectsRoot { // aka. the 'catalog' object, which is the root object representing the PDF
-		int page_count;
-		std::vector<std::size_t> pages; // refs to pages
+		int page_count; // from the page tree root's /Count, until the page index is built
+		objectRef pages_root{-1, 0}; // the root node of the page tree
+		std::vector<pageEntry> pages; // every page in order, once the page index is built. see build_page_index()
+		std::vector<objectRef> indexed_page_refs; // every page in order, when they were read from a sidecar index
+		std::once_flag pages_once;
+		std::atomic<bool> pages_indexed{false};
 		int object_gen_number;
-		std::string object_contents;
 	};
 
+    // what the resource cache keeps of an XObject, read from its dictionary once per document
+    struct xObjectInfo {
+        std::string subtype; // including the '/', e.g. /Image or /Form
+        // for images
+        int width = 0;
+        int height = 0;
+        int bits_per_component = 0;
+        int components = 0; // colour components per pixel, from the colour space
+        colour_space clr_space = DEVICE_RGB;
+        bool interpolate = false;
+    };
+
+    /* fonts & XObjects are usually shared by many pages, so they are resolved once per document & cached by object ref, see get_font() &
+    get_x_obj_info(). pages on different threads share the cache */
+    struct resourceCache {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::shared_ptr<fontObject>> fonts;
+        std::unordered_map<uint64_t, std::shared_ptr<const xObjectInfo>> x_objects;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+    };
+
+    // one page's entry in the page offset hint table of a linearised file
+    struct pageHint {
+        int first_obj_num; // the page object, which is the first of the page's objects
+        std::size_t offset; // where the page's objects start in the file
+        std::size_t length; // bytes up to the start of the next page's objects
+    };
+
+    /* the parameters of a linearised file, from its linearisation dictionary. the catalog & every object of the first page lie within the first
+    /E bytes & are covered by the first-page xref at the start of the file, so the first page can be parsed before the rest is read */
+    struct linearisationInfo {
+        bool linearised = false;
+        std::size_t first_page_end = 0; // /E, the end of the first page's objects
+        int first_page_obj_num = -1; // /O
+        int page_count = 0; // /N
+        std::size_t hint_offset = 0; // /H, the primary hint stream's offset & length
+        std::size_t hint_length = 0;
+        std::once_flag hints_once;
+        std::vector<pageHint> page_hints; // from the page offset hint table, read when a page other than the first is needed. see load_page_hints()
+    };
+
     struct docCore {
-        std::string doc_contents;  // The entire content of the document
+        mappedFile file; // owns the document's bytes, doc_contents views into it
+        std::string_view doc_contents;  // The entire content of the document
         refStruct ref_struct; // the document's primary ref struct, can either be a traler or xrefStream
-        std::map<int, std::map<int, xrefEntry>> object_refs; // xref object references to lookup objects
+        xrefIndex object_refs; // xref object references to lookup objects
+        std::map<int, objectStream> obj_streams; // /ObjStm objects inflated so far, keyed by their object number
+        std::map<int, objectStream> indexed_obj_streams; // /ObjStm offset tables read from a sidecar index, without contents until they are inflated
+        std::unordered_map<uint64_t, std::shared_ptr<const pdfObject>> object_cache; // objects parsed so far, keyed by obj num << 16 | gen num
+        std::recursive_mutex object_mutex; // guards object_cache, obj_streams & the xref, which pages parsed on different threads fill in lazily
+        resourceCache resources;
         objectsRoot objects_root;
+        linearisationInfo linearisation;
+        std::size_t deferred_xref_pos = std::string_view::npos; // a linearised file's main xref, read the first time an object isn't in the first-page xref
+    };
+
+    const std::size_t initial_fetch_window = 4096; // what is fetched for an object before its size is known
+    const std::size_t fetch_margin = 64; // room past an object to see what follows it, e.g. 'stream' after a dictionary or 'endstream' after data
+
+    /* returns the document's bytes up to offset + length, having made sure [offset, offset + length) was read when the document is only partly
+    available. the bytes before offset may not have been, so the view must only be scanned forwards from offset. complete documents are returned
+    whole, without fetching anything. throws std::runtime_error if the source fails, the unread chunks are never handed to the lexer */
+    std::string_view fetch(docCore& doc, std::size_t offset, std::size_t length) {
+        if (doc.file.complete()) return doc.doc_contents;
+        std::size_t size = doc.doc_contents.size();
+        if (offset >= size) return doc.doc_contents;
+        std::size_t end = length > size - offset ? size : offset + length;
+        if (!doc.file.ensure(offset, end - offset)) throw std::runtime_error("read failed at offset " + std::to_string(offset));
+        return doc.doc_contents.substr(0, end);
+    }
+
+    // fetches from offset until marker has been found with fetch_margin bytes after it, or the end of the document
+    std::string_view fetch_until(docCore& doc, std::size_t offset, std::string_view marker) {
+        for (std::size_t window = initial_fetch_window;; window *= 4) {
+            std::string_view data = fetch(doc, offset, window);
+            std::size_t marker_pos = data.find(marker, offset);
+            if (data.size() == doc.doc_contents.size()) return data;
+            if (marker_pos != std::string_view::npos && marker_pos + marker.size() + fetch_margin <= data.size()) return data;
+        }
+    }
+
+    /* runs parse on a lexer over the bytes fetched from offset. the size of what is parsed isn't known up front, so when parsing gets to the end
+    of what was fetched, a window 4 times larger is fetched & parse is run again */
+    template <typename Parse>
+    auto parse_fetched(docCore& doc, std::size_t offset, Parse parse) {
+        for (std::size_t window = initial_fetch_window;; window *= 4) {
+            std::string_view data = fetch(doc, offset, window);
+            lexer lex(data, offset);
+            auto result = parse(lex);
+            if (data.size() == doc.doc_contents.size() || lex.position() + fetch_margin < data.size()) return result;
+        }
+    }
+
+    // fetches & returns a stream's data: /Length bytes when 'endstream' follows them, otherwise everything up to 'endstream'
+    std::string_view fetch_stream_data(docCore& doc, std::size_t data_start, long long length) {
+        if (length >= 0) {
+            std::size_t length_window = static_cast<std::size_t>(std::min<unsigned long long>(length, doc.doc_contents.size())) + fetch_margin;
+            std::string_view data = read_stream_data(fetch(doc, data_start, length_window), data_start, length);
+            if (data.size() == static_cast<unsigned long long>(length) || doc.file.complete()) return data;
+        }
+        return read_stream_data(fetch_until(doc, data_start, "endstream"), data_start, length);
+    }
+
+    // parses the indirect object at offset, including its stream data if it has any
+    pdfObject parse_indirect_object(docCore& doc, std::size_t offset) {
+        if (offset >= doc.doc_contents.size()) return {};
+        std::size_t data_start = 0;
+        pdfObject obj = parse_fetched(doc, offset, [&](lexer& lex) {
+            skip_object_header(lex);
+            pdfObject parsed = parse_object(lex, &doc);
+            data_start = 0;
+            if (parsed.type == OBJ_DICT && is_keyword(lex.peek(), "stream")) {
+                lex.next();
+                data_start = lex.position();
+            }
+            return parsed;
+        });
+        if (data_start != 0) {
+            obj.type = OBJ_STREAM;
+            // /Length may be an indirect object, which is resolved through the xref. it is -1 if it can't be found
+            const pdfObject& length = obj.get("/Length");
+            obj.stream_data = fetch_stream_data(doc, data_start, length.type == OBJ_INTEGER ? length.int_value : -1);
+        }
+        return obj;
+    }
+
+
+    /* counts the heap allocations made while decoding streams: output buffers growing, zlib states & pipeline stages. read & reset through
+    get_decode_allocation_count() & reset_decode_allocation_count(), e.g. around parsing a page */
+    std::atomic<uint64_t> decode_allocations{0};
+
+    // grows out to at least size, counting the reallocation if it needs one
+    template <typename Container>
+    void grow_output(Container& out, std::size_t size) {
+        std::size_t capacity = out.capacity();
+        out.resize(size);
+        if (out.capacity() != capacity) decode_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /* zlib inflate states are kept per thread & reused through inflateReset(), which is far cheaper than inflateInit() & the 7 KB + 32 KB
+    window it allocates. a thread can have several in use at once (e.g. an /ObjStm inflated while a content stream is being decoded) */
+    struct inflaterPool {
+        std::vector<z_stream*> free_streams;
+
+        ~inflaterPool() {
+            for (z_stream* zs : free_streams) {
+                inflateEnd(zs);
+                delete zs;
+            }
+        }
     };
 
-    docCore doc_core {}; // contains essential document components, initialised to defaults, updated whenever a PDF is opened
+    thread_local inflaterPool inflater_pool;
 
+    // holds a reset inflate state from the calling thread's pool for its lifetime, zs is nullptr if zlib couldn't be initialised
+    struct pooledInflater {
+        z_stream* zs = nullptr;
+
+        pooledInflater() {
+            if (!inflater_pool.free_streams.empty()) {
+                zs = inflater_pool.free_streams.back();
+                inflater_pool.free_streams.pop_back();
+                inflateReset(zs);
+                return;
+            }
+            decode_allocations.fetch_add(1, std::memory_order_relaxed);
+            zs = new z_stream{};
+            if (inflateInit(zs) != Z_OK) {
+                delete zs;
+                zs = nullptr;
+            }
+        }
+        ~pooledInflater() {
+            if (zs) inflater_pool.free_streams.push_back(zs);
+        }
+        pooledInflater(const pooledInflater&) = delete;
+        pooledInflater& operator=(const pooledInflater&) = delete;
+    };
 
-    std::string isolate_object_contents(const std::string& main_str, std::size_t object_offset) {
-        return main_str.substr(object_offset, main_str.find("endobj", object_offset) - object_offset);
+    /* inflates data straight onto the end of out, which is grown to size_hint up front & doubled whenever it fills, so an accurate hint means a
+    single allocation & no copies. returns false if the data is corrupt or truncated, out then holds what could be inflated */
+    template <typename Container>
+    bool inflate_into(std::string_view data, Container& out, std::size_t size_hint) {
+        pooledInflater inflater;
+        if (!inflater.zs) return false;
+        z_stream& zs = *inflater.zs;
+
+        std::size_t start = out.size();
+        std::size_t written = start;
+        grow_output(out, start + std::max<std::size_t>(size_hint, 1024));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        zs.avail_in = static_cast<uInt>(data.size());
+
+        bool ok = false;
+        while (true) {
+            if (written == out.size()) grow_output(out, out.size() * 2);
+            std::size_t space = std::min<std::size_t>(out.size() - written, UINT32_MAX);
+            zs.next_out = reinterpret_cast<Bytef*>(&out[written]);
+            zs.avail_out = static_cast<uInt>(space);
+            int ret = inflate(&zs, Z_NO_FLUSH);
+            written += space - zs.avail_out;
+            if (ret == Z_STREAM_END) {
+                ok = true;
+                break;
+            }
+            if (ret != Z_OK && !(ret == Z_BUF_ERROR && zs.avail_out == 0)) break; // corrupt, or out of input before the end of the data
+        }
+        out.resize(written);
+        return ok;
     }
 
-    /* from PDF 1.5 onwards, PDFs can compress most of their objects into a stream contained in an object give the type: /ObjStm
-    this function will decompress these /ObjStm objects & update doc_contents to store the PDF in its standard form. used in parse_xref_stream() */
-    std::string inflate_obj_stream(int obj_num) { 
-        boost::regex obj_stream_regex(std::to_string(obj_num) + R"(\s+\d+\s+obj\s*<<[^>]*?/Type\s*/ObjStm[^>]*?>>\s*stream\r?\n([\s\S]*?)\r?\nendstream\r?\nendobj)");
-        boost::smatch obj_match;
-        boost::regex_search(doc_core.doc_contents, obj_match, obj_stream_regex);
-        std::string obj_stream = obj_match[1];
+    /* stream decode pipeline. a stream's /Filter array is turned into a chain of stages, each fed its input a chunk at a time & passing its output
+    on to the next stage as it goes, so no stage ever holds a whole intermediate stream. the last stage is a sink chosen by the caller */
+
+    struct decodeStage {
+        static constexpr std::size_t chunk_size = 16384; // stages pass their output on in pieces of at most about this size
+
+        decodeStage* next = nullptr;
+
+        virtual ~decodeStage() = default;
+        // decodes a chunk of input, returns false on a fatal error, in which case the output passed on so far is kept
+        virtual bool write(const uint8_t* data, std::size_t size) = 0;
+        // called once after the last chunk, flushes whatever output is still buffered
+        virtual bool finish() { return flush() && (!next || next->finish()); }
 
-        std::cout << "there is one of these";
+    protected:
+        std::vector<uint8_t> buffer; // output waiting to be passed on
+
+        bool emit(const uint8_t* data, std::size_t size) { return size == 0 || next->write(data, size); }
+        bool flush() {
+            bool ok = emit(buffer.data(), buffer.size());
+            buffer.clear();
+            return ok;
+        }
+        bool flush_if_full() { return buffer.size() < chunk_size || flush(); }
+    };
+
+    // appends the decoded stream to out. Container is std::string or std::vector<uint8_t>
+    template <typename Container>
+    struct appendSink : decodeStage {
+        Container& out;
+
+        explicit appendSink(Container& out) : out(out) {}
+        bool write(const uint8_t* data, std::size_t size) override {
+            std::size_t capacity = out.capacity();
+            out.insert(out.end(), data, data + size);
+            if (out.capacity() != capacity) decode_allocations.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        bool finish() override { return true; }
+    };
+
+    struct flateStage : decodeStage {
+        pooledInflater inflater;
+        bool ended = false;
+
+        bool write(const uint8_t* data, std::size_t size) override {
+            if (!inflater.zs) return false;
+            if (ended) return true; // anything after the end of the deflate data is padding
+            z_stream& zs = *inflater.zs;
+            uint8_t out[chunk_size];
+            zs.next_in = const_cast<Bytef*>(data);
+            zs.avail_in = static_cast<uInt>(size);
+            do {
+                zs.next_out = out;
+                zs.avail_out = sizeof(out);
+                int ret = inflate(&zs, Z_NO_FLUSH);
+                if (!emit(out, sizeof(out) - zs.avail_out)) return false;
+                if (ret == Z_STREAM_END) {
+                    ended = true;
+                    return true;
+                }
+                if (ret == Z_BUF_ERROR) break; // needs more input
+                if (ret != Z_OK) return false; // corrupt data, keep what was inflated before it
+            } while (zs.avail_in > 0 || zs.avail_out == 0);
+            return true;
+        }
+    };
+
+    /* PNG & TIFF predictor kernels. each undoes one row in place: cur is the row without its PNG filter type byte, up the previously decoded row
+    & bpp the bytes per pixel (at least 1). the PNG filters predict each byte from its left, upper & upper-left neighbours */
+
+    void unfilter_sub_scalar(uint8_t* cur, std::size_t size, std::size_t bpp) {
+        for (std::size_t i = bpp; i < size; ++i) cur[i] = static_cast<uint8_t>(cur[i] + cur[i - bpp]);
+    }
+
+    void unfilter_up_scalar(uint8_t* cur, const uint8_t* up, std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) cur[i] = static_cast<uint8_t>(cur[i] + up[i]);
+    }
+
+    void unfilter_average_scalar(uint8_t* cur, const uint8_t* up, std::size_t size, std::size_t bpp) {
+        for (std::size_t i = 0; i < size; ++i) {
+            int left = i >= bpp ? cur[i - bpp] : 0;
+            cur[i] = static_cast<uint8_t>(cur[i] + ((left + up[i]) >> 1));
+        }
+    }
+
+    void unfilter_paeth_scalar(uint8_t* cur, const uint8_t* up, std::size_t size, std::size_t bpp) {
+        for (std::size_t i = 0; i < size; ++i) {
+            int left = i >= bpp ? cur[i - bpp] : 0;
+            int upper_left = i >= bpp ? up[i - bpp] : 0;
+            int estimate = left + up[i] - upper_left;
+            int dist_left = std::abs(estimate - left);
+            int dist_up = std::abs(estimate - up[i]);
+            int dist_upper_left = std::abs(estimate - upper_left);
+            // ties favour left, then up
+            int prediction = (dist_left <= dist_up && dist_left <= dist_upper_left) ? left : (dist_up <= dist_upper_left ? up[i] : upper_left);
+            cur[i] = static_cast<uint8_t>(cur[i] + prediction);
+        }
+    }
+
+#ifdef PDF_PARSER_HAS_X86_SIMD
+    /* SSE2 & AVX2 kernels, chosen at runtime by get_predictor_kernels(). up is the only filter without a dependency between neighbouring
+    pixels, so it is the only one widened to 256 bits. sub, average & paeth depend on the pixel to their left & are done a pixel per 128-bit
+    step. rows must be followed by at least one readable byte */
+
+    template <std::size_t bpp>
+    __attribute__((target("sse2"))) inline __m128i load_pixel(const uint8_t* p) {
+        uint32_t pixel = 0;
+        std::memcpy(&pixel, p, bpp == 3 ? 4 : bpp); // a 4 byte load is much faster, the extra byte is never stored back
+        return _mm_cvtsi32_si128(static_cast<int>(pixel));
+    }
+
+    template <std::size_t bpp>
+    __attribute__((target("sse2"))) inline void store_pixel(uint8_t* p, __m128i value) {
+        uint32_t pixel = static_cast<uint32_t>(_mm_cvtsi128_si32(value));
+        std::memcpy(p, &pixel, bpp);
+    }
+
+    __attribute__((target("sse2"))) void unfilter_up_sse2(uint8_t* cur, const uint8_t* up, std::size_t size) {
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + i)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(cur + i), sum);
+        }
+        unfilter_up_scalar(cur + i, up + i, size - i);
+    }
+
+    __attribute__((target("avx2"))) void unfilter_up_avx2(uint8_t* cur, const uint8_t* up, std::size_t size) {
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i sum = _mm256_add_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(cur + i), sum);
+        }
+        unfilter_up_scalar(cur + i, up + i, size - i);
+    }
+
+    // the pixel size is a template parameter so that pixels load & store with fixed size moves
+    template <std::size_t bpp>
+    __attribute__((target("sse2"))) void unfilter_sub_sse2(uint8_t* cur, std::size_t size) {
+        __m128i left = _mm_setzero_si128();
+        std::size_t i = 0;
+        for (; i + bpp <= size; i += bpp) {
+            left = _mm_add_epi8(load_pixel<bpp>(cur + i), left);
+            store_pixel<bpp>(cur + i, left);
+        }
+        for (; i < size; ++i) cur[i] = static_cast<uint8_t>(cur[i] + cur[i - bpp]); // a partial pixel at the end of the row
+    }
+
+    template <std::size_t bpp>
+    __attribute__((target("sse2"))) void unfilter_average_sse2(uint8_t* cur, const uint8_t* up, std::size_t size) {
+        const __m128i ones = _mm_set1_epi8(1);
+        __m128i left = _mm_setzero_si128();
+        std::size_t i = 0;
+        for (; i + bpp <= size; i += bpp) {
+            __m128i upper = load_pixel<bpp>(up + i);
+            // _mm_avg_epu8 rounds up, the predictor rounds down
+            __m128i average = _mm_sub_epi8(_mm_avg_epu8(left, upper), _mm_and_si128(_mm_xor_si128(left, upper), ones));
+            left = _mm_add_epi8(load_pixel<bpp>(cur + i), average);
+            store_pixel<bpp>(cur + i, left);
+        }
+        for (; i < size; ++i) cur[i] = static_cast<uint8_t>(cur[i] + ((cur[i - bpp] + up[i]) >> 1));
+    }
+
+    __attribute__((target("sse2"))) inline __m128i select_epi16(__m128i mask, __m128i if_set, __m128i if_clear) {
+        return _mm_or_si128(_mm_and_si128(mask, if_set), _mm_andnot_si128(mask, if_clear));
+    }
+
+    template <std::size_t bpp>
+    __attribute__((target("sse2"))) void unfilter_paeth_sse2(uint8_t* cur, const uint8_t* up, std::size_t size) {
+        // the pixels are widened to 16 bits, as the distances need 9
+        const __m128i zero = _mm_setzero_si128();
+        __m128i left = zero;
+        __m128i upper_left = zero;
+        std::size_t i = 0;
+        for (; i + bpp <= size; i += bpp) {
+            __m128i upper = _mm_unpacklo_epi8(load_pixel<bpp>(up + i), zero);
+            __m128i dist_left = _mm_sub_epi16(upper, upper_left); // estimate - left
+            __m128i dist_up = _mm_sub_epi16(left, upper_left); // estimate - up
+            __m128i dist_upper_left = _mm_add_epi16(dist_left, dist_up); // estimate - upper left
+            dist_left = _mm_max_epi16(dist_left, _mm_sub_epi16(zero, dist_left));
+            dist_up = _mm_max_epi16(dist_up, _mm_sub_epi16(zero, dist_up));
+            dist_upper_left = _mm_max_epi16(dist_upper_left, _mm_sub_epi16(zero, dist_upper_left));
+
+            // ties favour left, then up
+            __m128i smallest = _mm_min_epi16(dist_upper_left, _mm_min_epi16(dist_left, dist_up));
+            __m128i prediction = select_epi16(_mm_cmpeq_epi16(smallest, dist_up), upper, upper_left);
+            prediction = select_epi16(_mm_cmpeq_epi16(smallest, dist_left), left, prediction);
+
+            __m128i pixel = _mm_add_epi8(load_pixel<bpp>(cur + i), _mm_packus_epi16(prediction, prediction));
+            store_pixel<bpp>(cur + i, pixel);
+            left = _mm_unpacklo_epi8(pixel, zero);
+            upper_left = upper;
+        }
+        for (; i < size; ++i) { // a partial pixel at the end of the row
+            int estimate = cur[i - bpp] + up[i] - up[i - bpp];
+            int dist_left = std::abs(estimate - cur[i - bpp]);
+            int dist_up = std::abs(estimate - up[i]);
+            int dist_upper_left = std::abs(estimate - up[i - bpp]);
+            int prediction = (dist_left <= dist_up && dist_left <= dist_upper_left) ? cur[i - bpp] : (dist_up <= dist_upper_left ? up[i] : up[i - bpp]);
+            cur[i] = static_cast<uint8_t>(cur[i] + prediction);
+        }
+    }
+
+    // dispatch on the pixel size, other sizes than the 3 & 4 bytes of RGB & CMYK pixels go through the scalar kernels
+    __attribute__((target("sse2"))) void unfilter_sub_sse2(uint8_t* cur, std::size_t size, std::size_t bpp) {
+        if (bpp == 3) unfilter_sub_sse2<3>(cur, size);
+        else if (bpp == 4) unfilter_sub_sse2<4>(cur, size);
+        else unfilter_sub_scalar(cur, size, bpp);
+    }
+
+    __attribute__((target("sse2"))) void unfilter_average_sse2(uint8_t* cur, const uint8_t* up, std::size_t size, std::size_t bpp) {
+        if (bpp == 3) unfilter_average_sse2<3>(cur, up, size);
+        else if (bpp == 4) unfilter_average_sse2<4>(cur, up, size);
+        else unfilter_average_scalar(cur, up, size, bpp);
+    }
+
+    __attribute__((target("sse2"))) void unfilter_paeth_sse2(uint8_t* cur, const uint8_t* up, std::size_t size, std::size_t bpp) {
+        if (bpp == 3) unfilter_paeth_sse2<3>(cur, up, size);
+        else if (bpp == 4) unfilter_paeth_sse2<4>(cur, up, size);
+        else unfilter_paeth_scalar(cur, up, size, bpp);
+    }
+#endif
+
+    struct predictorKernels {
+        void (*sub)(uint8_t* cur, std::size_t size, std::size_t bpp);
+        void (*up)(uint8_t* cur, const uint8_t* up, std::size_t size);
+        void (*average)(uint8_t* cur, const uint8_t* up, std::size_t size, std::size_t bpp);
+        void (*paeth)(uint8_t* cur, const uint8_t* up, std::size_t size, std::size_t bpp);
+    };
+
+    // the fastest kernels the CPU supports, checked once
+    const predictorKernels& get_predictor_kernels() {
+        static const predictorKernels kernels = [] {
+            predictorKernels selected{ unfilter_sub_scalar, unfilter_up_scalar, unfilter_average_scalar, unfilter_paeth_scalar };
+#ifdef PDF_PARSER_HAS_X86_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("sse2")) selected = { unfilter_sub_sse2, unfilter_up_sse2, unfilter_average_sse2, unfilter_paeth_sse2 };
+            if (__builtin_cpu_supports("avx2")) selected.up = unfilter_up_avx2;
+#endif
+            return selected;
+        }();
+        return kernels;
+    }
+
+    /* TIFF predictor 2 predicts each sample from the same colour component of the pixel to its left. samples are packed bits_per_component wide,
+    16-bit samples being big-endian */
+    void undo_tiff_predictor(uint8_t* row, std::size_t row_size, int colors, int bits_per_component, int columns) {
+        std::size_t samples = static_cast<std::size_t>(colors) * columns;
+        if (bits_per_component == 8) {
+            unfilter_sub_scalar(row, std::min(row_size, samples), colors);
+        }
+        else if (bits_per_component == 16) {
+            for (std::size_t i = 2 * colors; i + 1 < row_size && i / 2 < samples; i += 2) {
+                unsigned value = ((row[i] << 8) | row[i + 1]) + ((row[i - 2 * colors] << 8) | row[i - 2 * colors + 1]);
+                row[i] = static_cast<uint8_t>(value >> 8);
+                row[i + 1] = static_cast<uint8_t>(value);
+            }
+        }
+        else if (bits_per_component == 1 || bits_per_component == 2 || bits_per_component == 4) {
+            unsigned mask = (1u << bits_per_component) - 1;
+            // samples are packed from the most significant bit down
+            auto shift_of = [bits_per_component](std::size_t sample) { return 8 - bits_per_component - static_cast<int>(sample * bits_per_component & 7); };
+            auto byte_of = [bits_per_component](std::size_t sample) { return sample * bits_per_component >> 3; };
+            for (std::size_t sample = colors; sample < samples && byte_of(sample) < row_size; ++sample) {
+                unsigned left = (row[byte_of(sample - colors)] >> shift_of(sample - colors)) & mask;
+                uint8_t& byte = row[byte_of(sample)];
+                int shift = shift_of(sample);
+                unsigned value = (((byte >> shift) & mask) + left) & mask;
+                byte = static_cast<uint8_t>((byte & ~(mask << shift)) | (value << shift));
+            }
+        }
+    }
+
+    /* PNG & TIFF predictors, which /FlateDecode & /LZWDecode apply after decoding. PNG predictors (10-15) prefix every row with a filter type
+    byte, which is dropped from the output & selects the filter for that row, the row above the first one being all 0s. rows are undone in
+    place, in two buffers which swap roles after each row */
+    struct predictorStage : decodeStage {
+        int predictor;
+        int colors;
+        int bits_per_component;
+        int columns;
+        std::size_t bytes_per_pixel;
+        std::size_t row_size; // without the PNG filter type byte
+        std::vector<uint8_t> row; // the row being filled, with its PNG filter type byte & a byte of padding for the SIMD kernels
+        std::vector<uint8_t> prior_row; // the previously decoded row, laid out the same way
+        std::size_t filled = 0;
+
+        predictorStage(int predictor, int colors, int bits_per_component, int columns)
+            : predictor(predictor), colors(std::max(colors, 1)), bits_per_component(std::max(bits_per_component, 1)), columns(std::max(columns, 1)) {
+            std::size_t bits_per_pixel = static_cast<std::size_t>(this->colors) * this->bits_per_component;
+            bytes_per_pixel = std::max<std::size_t>(1, (bits_per_pixel + 7) / 8);
+            row_size = (bits_per_pixel * this->columns + 7) / 8;
+            row.assign(row_size + 2, 0);
+            prior_row.assign(row_size + 2, 0);
+        }
+
+        bool write(const uint8_t* data, std::size_t size) override {
+            std::size_t row_start = predictor >= 10 ? 0 : 1; // TIFF rows have no filter type byte
+            std::size_t row_end = row_size + 1;
+            while (size > 0) {
+                std::size_t count = std::min(size, row_end - row_start - filled);
+                std::copy(data, data + count, row.begin() + row_start + filled);
+                filled += count;
+                data += count;
+                size -= count;
+                if (row_start + filled < row_end) break;
+                filled = 0;
+                if (!emit_row()) return false;
+            }
+            return true;
+        }
+
+        bool emit_row() {
+            uint8_t* cur = row.data() + 1;
+            if (predictor == 2) {
+                undo_tiff_predictor(cur, row_size, colors, bits_per_component, columns);
+                return emit(cur, row_size);
+            }
+
+            const predictorKernels& kernels = get_predictor_kernels();
+            const uint8_t* up = prior_row.data() + 1;
+            switch (row[0]) {
+            case PNG_NONE:
+                break;
+            case PNG_SUB:
+                kernels.sub(cur, row_size, bytes_per_pixel);
+                break;
+            case PNG_UP:
+                kernels.up(cur, up, row_size);
+                break;
+            case PNG_AVERAGE:
+                kernels.average(cur, up, row_size, bytes_per_pixel);
+                break;
+            case PNG_PAETH:
+                kernels.paeth(cur, up, row_size, bytes_per_pixel);
+                break;
+            default:
+                return false; // unknown filter type, the rest of the stream can't be trusted
+            }
+            bool ok = emit(cur, row_size);
+            std::swap(row, prior_row);
+            return ok;
+        }
+    };
+
+    struct asciiHexStage : decodeStage {
+        int high_nibble = -1; // the first digit of a byte, while waiting for the second
+        bool ended = false;
+
+        bool write(const uint8_t* data, std::size_t size) override {
+            for (std::size_t i = 0; i < size && !ended; ++i) {
+                int c = data[i];
+                int nibble;
+                if (c >= '0' && c <= '9') nibble = c - '0';
+                else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+                else if (c == '>') { ended = true; break; }
+                else if (std::isspace(c)) continue;
+                else return false;
+
+                if (high_nibble < 0) high_nibble = nibble;
+                else {
+                    buffer.push_back(static_cast<uint8_t>(high_nibble << 4 | nibble));
+                    high_nibble = -1;
+                    if (!flush_if_full()) return false;
+                }
+            }
+            return flush();
+        }
+
+        bool finish() override {
+            // an odd final digit is followed by an implicit 0
+            if (high_nibble >= 0) buffer.push_back(static_cast<uint8_t>(high_nibble << 4));
+            high_nibble = -1;
+            return decodeStage::finish();
+        }
+    };
+
+    struct ascii85Stage : decodeStage {
+        uint32_t group = 0;
+        int group_size = 0;
+        bool ended = false;
+
+        bool write(const uint8_t* data, std::size_t size) override {
+            for (std::size_t i = 0; i < size && !ended; ++i) {
+                int c = data[i];
+                if (std::isspace(c)) continue;
+                if (c == '~') { ended = true; break; } // '~>' ends the data
+                if (c == 'z' && group_size == 0) { // shorthand for 4 zero bytes
+                    buffer.insert(buffer.end(), 4, 0);
+                }
+                else if (c >= '!' && c <= 'u') {
+                    group = group * 85 + (c - '!');
+                    if (++group_size == 5) {
+                        emit_group(4);
+                        group = 0;
+                        group_size = 0;
+                    }
+                }
+                else return false;
+                if (!flush_if_full()) return false;
+            }
+            return flush();
+        }
+
+        void emit_group(int count) {
+            for (int shift = 24; count > 0; shift -= 8, --count) buffer.push_back(static_cast<uint8_t>(group >> shift));
+        }
+
+        bool finish() override {
+            // a final partial group of n characters is padded with 'u' & gives n - 1 bytes
+            if (group_size > 1) {
+                int count = group_size - 1;
+                for (; group_size < 5; ++group_size) group = group * 85 + 84;
+                emit_group(count);
+            }
+            group_size = 0;
+            return decodeStage::finish();
+        }
+    };
+
+    struct lzwStage : decodeStage {
+        static constexpr int clear_table = 256;
+        static constexpr int end_of_data = 257;
+        static constexpr int max_codes = 4096;
+
+        int early_change;
+        uint16_t prefix[max_codes]; // each code is the code before it plus one byte
+        uint8_t suffix[max_codes];
+        uint8_t first_byte[max_codes];
+        uint16_t length[max_codes];
+        int next_code = 258;
+        int code_length = 9;
+        int prev_code = -1;
+        uint32_t bits = 0;
+        int bit_count = 0;
+        bool ended = false;
+
+        explicit lzwStage(int early_change) : early_change(early_change) {
+            for (int i = 0; i < 256; ++i) {
+                suffix[i] = first_byte[i] = static_cast<uint8_t>(i);
+                length[i] = 1;
+            }
+        }
+
+        void output_code(int code) {
+            // the string is written backwards, walking its prefixes
+            std::size_t start = buffer.size();
+            buffer.resize(start + length[code]);
+            for (std::size_t pos = buffer.size(); pos-- > start; code = prefix[code]) buffer[pos] = suffix[code];
+        }
+
+        bool write(const uint8_t* data, std::size_t size) override {
+            for (std::size_t i = 0; i < size && !ended; ++i) {
+                bits = bits << 8 | data[i];
+                bit_count += 8;
+                while (bit_count >= code_length && !ended) {
+                    bit_count -= code_length;
+                    int code = static_cast<int>(bits >> bit_count) & ((1 << code_length) - 1);
+                    if (!decode_code(code)) return false;
+                    if (!flush_if_full()) return false;
+                }
+            }
+            return flush();
+        }
+
+        bool decode_code(int code) {
+            if (code == clear_table) {
+                next_code = 258;
+                code_length = 9;
+                prev_code = -1;
+                return true;
+            }
+            if (code == end_of_data) {
+                ended = true;
+                return true;
+            }
+            if (prev_code < 0) {
+                if (code > 255) return false;
+                output_code(code);
+                prev_code = code;
+                return true;
+            }
+            if (code > next_code) return false;
+
+            // the new entry is the previous string plus the first byte of this one, which for code == next_code is the previous string's own first byte
+            uint8_t first = code < next_code ? first_byte[code] : first_byte[prev_code];
+            if (next_code < max_codes) {
+                prefix[next_code] = static_cast<uint16_t>(prev_code);
+                suffix[next_code] = first;
+                first_byte[next_code] = first_byte[prev_code];
+                length[next_code] = static_cast<uint16_t>(length[prev_code] + 1);
+                ++next_code;
+            }
+            if (code >= next_code) return false; // only possible once the table is full
+            output_code(code);
+            prev_code = code;
+            if (next_code + early_change >= (1 << code_length) && code_length < 12) ++code_length;
+            return true;
+        }
+    };
+
+    struct runLengthStage : decodeStage {
+        int literal_left = 0; // bytes left to copy from a literal run
+        int repeat_count = 0; // when set, the next byte is repeated this many times
+        bool ended = false;
+
+        bool write(const uint8_t* data, std::size_t size) override {
+            for (std::size_t i = 0; i < size && !ended; ++i) {
+                uint8_t byte = data[i];
+                if (literal_left > 0) {
+                    buffer.push_back(byte);
+                    --literal_left;
+                }
+                else if (repeat_count > 0) {
+                    buffer.insert(buffer.end(), repeat_count, byte);
+                    repeat_count = 0;
+                }
+                else if (byte < 128) literal_left = byte + 1;
+                else if (byte > 128) repeat_count = 257 - byte;
+                else ended = true; // 128 marks the end of the data
+                if (!flush_if_full()) return false;
+            }
+            return flush();
+        }
+    };
+
+    streamFilter get_filter_type(std::string_view filter_name) {
+        // inline images may use the abbreviated names
+        if (filter_name == "/FlateDecode" || filter_name == "/Fl") return FLATE_DECODE_FILTER;
+        if (filter_name == "/LZWDecode" || filter_name == "/LZW") return LZW_DECODE_FILTER;
+        if (filter_name == "/ASCIIHexDecode" || filter_name == "/AHx") return ASCII_HEX_DECODE_FILTER;
+        if (filter_name == "/ASCII85Decode" || filter_name == "/A85") return ASCII_85_DECODE_FILTER;
+        if (filter_name == "/RunLengthDecode" || filter_name == "/RL") return RUN_LENGTH_DECODE_FILTER;
+        if (filter_name == "/DCTDecode" || filter_name == "/DCT") return DCT_DECODE_FILTER;
+        if (filter_name == "/JPXDecode") return JPX_DECODE_FILTER;
+        if (filter_name == "/CCITTFaxDecode" || filter_name == "/CCF") return CCITT_FAX_DECODE_FILTER;
+        if (filter_name == "/JBIG2Decode") return JBIG2_DECODE_FILTER;
+        if (filter_name == "/Crypt") return CRYPT_FILTER;
+        return UNKNOWN_FILTER;
+    }
+
+    // returns the stage decoding filter, or nullptr for filters left to the caller (image codecs) or not supported
+    std::unique_ptr<decodeStage> make_decode_stage(streamFilter filter, const pdfObject& decode_parms) {
+        switch (filter) {
+        case FLATE_DECODE_FILTER:
+            return std::make_unique<flateStage>();
+        case LZW_DECODE_FILTER:
+            return std::make_unique<lzwStage>(static_cast<int>(decode_parms.get_int("/EarlyChange", 1)));
+        case ASCII_HEX_DECODE_FILTER:
+            return std::make_unique<asciiHexStage>();
+        case ASCII_85_DECODE_FILTER:
+            return std::make_unique<ascii85Stage>();
+        case RUN_LENGTH_DECODE_FILTER:
+            return std::make_unique<runLengthStage>();
+        default:
+            return nullptr;
+        }
+    }
+
+    /* builds the stages decoding stream's data through every filter in its /Filter array into sink. /Filter & /DecodeParms are either a single
+    name & dict or two parallel arrays. the pipeline stops at the first filter without a stage, which is returned (NO_FILTER when the stream is
+    fully decoded), so that e.g. /DCTDecode image data reaches the caller still encoded. the stage data is written to is returned in first */
+    streamFilter build_decode_pipeline(const pdfObject& stream, decodeStage& sink, std::vector<std::unique_ptr<decodeStage>>& stages, decodeStage*& first) {
+        const pdfObject& filters = stream.get("/Filter");
+        const pdfObject& parms = stream.get("/DecodeParms");
+        std::size_t filter_count = filters.type == OBJ_ARRAY ? filters.array.size() : (filters.type == OBJ_NAME ? 1 : 0);
+
+        streamFilter remaining = NO_FILTER;
+        for (std::size_t i = 0; i < filter_count; ++i) {
+            const pdfObject& filter_name = filters.type == OBJ_ARRAY ? resolve(filters.array[i]) : filters;
+            const pdfObject& filter_parms = parms.type == OBJ_ARRAY ? (i < parms.array.size() ? resolve(parms.array[i]) : null_object) : parms;
+            streamFilter filter = get_filter_type(filter_name.text);
+            std::unique_ptr<decodeStage> stage = make_decode_stage(filter, filter_parms);
+            if (!stage) {
+                remaining = filter;
+                break;
+            }
+            stages.push_back(std::move(stage));
+
+            int predictor = static_cast<int>(filter_parms.get_int("/Predictor", 1));
+            if ((filter == FLATE_DECODE_FILTER || filter == LZW_DECODE_FILTER) && (predictor == 2 || predictor >= 10)) {
+                stages.push_back(std::make_unique<predictorStage>(predictor, static_cast<int>(filter_parms.get_int("/Colors", 1)),
+                    static_cast<int>(filter_parms.get_int("/BitsPerComponent", 8)), static_cast<int>(filter_parms.get_int("/Columns", 1))));
+            }
+        }
+
+        decode_allocations.fetch_add(stages.size(), std::memory_order_relaxed);
+        for (std::size_t i = 0; i < stages.size(); ++i) stages[i]->next = i + 1 < stages.size() ? stages[i + 1].get() : &sink;
+        first = stages.empty() ? &sink : stages.front().get();
+        return remaining;
+    }
+
+    // decodes stream's data into sink in one go, see build_decode_pipeline()
+    streamFilter run_decode_pipeline(const pdfObject& stream, decodeStage& sink) {
+        std::vector<std::unique_ptr<decodeStage>> stages;
+        decodeStage* first = nullptr;
+        streamFilter remaining = build_decode_pipeline(stream, sink, stages, first);
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(stream.stream_data.data());
+        std::size_t size = stream.stream_data.size();
+        for (std::size_t pos = 0; pos < size; pos += decodeStage::chunk_size) {
+            if (!first->write(data + pos, std::min(decodeStage::chunk_size, size - pos))) break;
+        }
+        first->finish();
+        return remaining;
+    }
+
+    /* estimates a stream's decoded size: its /DL when given, otherwise size_hint when the caller knows the size (e.g. from an image's dimensions),
+    otherwise 4x the encoded size, a typical deflate ratio. both are capped, as deflate can't expand data by more than about 1032x */
+    std::size_t decoded_size_hint(const pdfObject& stream, std::size_t size_hint) {
+        std::size_t max_size = stream.stream_data.size() * 1032 + 1024;
+        long long decoded_length = stream.get_int("/DL", -1);
+        if (decoded_length >= 0) return std::min(static_cast<std::size_t>(decoded_length), max_size);
+        if (size_hint > 0) return std::min(size_hint, max_size);
+        return stream.stream_data.size() * 4;
+    }
+
+    // a lone /FlateDecode without a predictor, by far the most common case, which skips the pipeline & inflates straight into the output
+    bool is_plain_flate(const pdfObject& stream) {
+        const pdfObject& filters = stream.get("/Filter");
+        const pdfObject& parms = stream.get("/DecodeParms");
+        const pdfObject& filter = filters.type == OBJ_ARRAY && filters.array.size() == 1 ? resolve(filters.array[0]) : filters;
+        const pdfObject& filter_parms = parms.type == OBJ_ARRAY && parms.array.size() == 1 ? resolve(parms.array[0]) : parms;
+        return filter.type == OBJ_NAME && get_filter_type(filter.text) == FLATE_DECODE_FILTER && filter_parms.get_int("/Predictor", 1) == 1;
+    }
+
+    /* decodes stream into out, which is a std::string or std::vector<uint8_t>. returns the first filter left undecoded, see run_decode_pipeline().
+    out is sized from decoded_size_hint() before decoding */
+    template <typename Container>
+    streamFilter decode_stream(const pdfObject& stream, Container& out, std::size_t size_hint = 0) {
+        size_hint = decoded_size_hint(stream, size_hint);
+        if (is_plain_flate(stream)) {
+            inflate_into(stream.stream_data, out, size_hint);
+            return NO_FILTER;
+        }
+
+        std::size_t capacity = out.capacity();
+        out.reserve(out.size() + size_hint);
+        if (out.capacity() != capacity) decode_allocations.fetch_add(1, std::memory_order_relaxed);
+        appendSink<Container> sink(out);
+        return run_decode_pipeline(stream, sink);
+    }
+
+    /* decodes a stream a piece at a time as its output is asked for, for streams too large to be worth decoding whole (e.g. content streams).
+    output is appended to the string given on construction */
+    class streamDecoder {
+    public:
+        static constexpr std::size_t input_size = 1024; // encoded bytes fed to the pipeline at a time, which bounds how far a read overshoots
+
+        streamDecoder(const pdfObject& stream, std::string& out) : data(stream.stream_data), sink(out), out(out) {
+            if (is_plain_flate(stream)) {
+                inflater = std::make_unique<pooledInflater>();
+                if (inflater->zs) {
+                    inflater->zs->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+                    inflater->zs->avail_in = static_cast<uInt>(data.size());
+                }
+            }
+            else build_decode_pipeline(stream, sink, stages, first);
+        }
+
+        // decodes until at least min_size bytes were appended to out or the stream ended, returns false once there was nothing left to append
+        bool read(std::size_t min_size) {
+            if (inflater) return inflate_some(min_size);
+            std::size_t start = out.size();
+            while (!finished && out.size() - start < min_size) {
+                if (pos == data.size()) {
+                    first->finish();
+                    finished = true;
+                    break;
+                }
+                std::size_t size = std::min(input_size, data.size() - pos);
+                // a fatal error ends the stream, the output before it is kept
+                if (!first->write(reinterpret_cast<const uint8_t*>(data.data() + pos), size)) pos = data.size();
+                else pos += size;
+            }
+            return out.size() > start || !finished;
+        }
+
+    private:
+        // plain /FlateDecode streams are inflated straight onto the end of out, min_size bytes at a time
+        bool inflate_some(std::size_t min_size) {
+            if (finished || !inflater->zs) return false;
+            z_stream& zs = *inflater->zs;
+            std::size_t start = out.size();
+            out.resize(start + min_size);
+            zs.next_out = reinterpret_cast<Bytef*>(&out[start]);
+            zs.avail_out = static_cast<uInt>(min_size);
+            int ret = inflate(&zs, Z_NO_FLUSH);
+            out.resize(out.size() - zs.avail_out);
+            // the end of the data, a corrupt stream or one cut short all end it, keeping what was inflated
+            if (ret != Z_OK) finished = true;
+            return out.size() > start || !finished;
+        }
+
+        std::unique_ptr<pooledInflater> inflater; // for plain /FlateDecode streams, which skip the pipeline
+        std::string_view data;
+        std::size_t pos = 0;
+        bool finished = false;
+        appendSink<std::string> sink;
+        std::string& out;
+        std::vector<std::unique_ptr<decodeStage>> stages;
+        decodeStage* first = nullptr;
+    };
+
+    uint64_t get_decode_allocation_count() {
+        return decode_allocations.load(std::memory_order_relaxed);
+    }
+
+    void reset_decode_allocation_count() {
+        decode_allocations.store(0, std::memory_order_relaxed);
+    }
+
+    // reads an unsigned integer at pos, skipping any whitespace before it. returns -1 if there is no number at pos
+    long long read_uint(std::string_view look_in, std::size_t& pos) {
+        while (pos < look_in.size() && std::isspace(static_cast<unsigned char>(look_in[pos]))) ++pos;
+        if (pos >= look_in.size() || !std::isdigit(static_cast<unsigned char>(look_in[pos]))) return -1;
+        long long value = 0;
+        while (pos < look_in.size() && std::isdigit(static_cast<unsigned char>(look_in[pos]))) {
+            value = value * 10 + (look_in[pos] - '0');
+            ++pos;
+        }
+        return value;
+    }
+
+    /* returns the decompressed /ObjStm with the given object number, inflating it on first use. /ObjStm have a sequence of numbers at their beggining,
+    these are key-value pairs where the key is the object number & the value, its offset relative to /First. they are decoded once here. the
+    stream is inflated without holding the object mutex, if two threads miss on the same /ObjStm at once both inflate it & the first one stored is kept */
+    const objectStream& load_obj_stream(docCore& doc, int obj_stm_num) {
+        objectStream obj_stream;
+        bool indexed = false;
+        {
+            std::lock_guard<std::recursive_mutex> lock(doc.object_mutex);
+            auto obj_stream_iter = doc.obj_streams.find(obj_stm_num);
+            if (obj_stream_iter != doc.obj_streams.end()) return obj_stream_iter->second;
+
+            // a sidecar index already holds the offset table, only the contents have to be inflated
+            auto indexed_iter = doc.indexed_obj_streams.find(obj_stm_num);
+            if (indexed_iter != doc.indexed_obj_streams.end()) {
+                obj_stream.obj_nums = indexed_iter->second.obj_nums;
+                obj_stream.obj_offsets = indexed_iter->second.obj_offsets;
+                indexed = true;
+            }
+        }
+
+        const pdfObject& stream_obj = get_object(doc, {obj_stm_num, 0}); // /ObjStm can't be compressed themselves, so gen is always 0
+        decode_stream(stream_obj, obj_stream.contents);
+
+        if (!indexed) {
+            long long obj_count = stream_obj.get_int("/N");
+            long long first = stream_obj.get_int("/First");
+
+            std::size_t pos = 0;
+            for (long long i = 0; i < obj_count; ++i) {
+                long long obj_num = read_uint(obj_stream.contents, pos);
+                long long offset = read_uint(obj_stream.contents, pos);
+                if (obj_num < 0 || offset < 0) break; // malformed header, keep the objects read so far
+                obj_stream.obj_nums.push_back(static_cast<int>(obj_num));
+                obj_stream.obj_offsets.push_back(static_cast<std::size_t>(first + offset));
+            }
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(doc.object_mutex);
+        doc.indexed_obj_streams.erase(obj_stm_num);
+        return doc.obj_streams.emplace(obj_stm_num, std::move(obj_stream)).first->second;
+    }
+
+    // the key objects are cached by, refs must have been checked to be in range
+    uint64_t object_key(objectRef ref) {
+        return (static_cast<uint64_t>(ref.obj_num) << 16) | static_cast<uint64_t>(ref.gen_num);
+    }
+
+    void load_deferred_xref(docCore& doc);
+
+    // looks ref up in the xref, reading a linearised file's main xref if it isn't in the first-page one. called with the object mutex held
+    bool find_xref_entry(docCore& doc, objectRef ref, xrefEntry& entry) {
+        if (doc.object_refs.find(ref, entry)) return true;
+        // linearised files only read their main xref once an object outside the first page is needed
+        if (doc.deferred_xref_pos == std::string_view::npos) return false;
+        load_deferred_xref(doc);
+        return doc.object_refs.find(ref, entry);
+    }
+
+    // parses the object ref points to from where its xref entry says it is stored. use get_object(), which only does this once per object
+    pdfObject load_object(docCore& doc, objectRef ref, const xrefEntry& entry) {
+        if (entry.status == 'n') return parse_indirect_object(doc, entry.object_offset);
+        if (entry.status != 'c') return {}; // free objects are null
+
+        const objectStream& obj_stream = load_obj_stream(doc, entry.obj_stm_num);
+        std::size_t index = static_cast<std::size_t>(entry.obj_stm_index);
+        if (index >= obj_stream.obj_offsets.size() || obj_stream.obj_nums[index] != ref.obj_num) return {};
+        if (obj_stream.obj_offsets[index] >= obj_stream.contents.size()) return {};
+        lexer lex(obj_stream.contents, obj_stream.obj_offsets[index]);
+        return parse_object(lex, &doc);
+    }
+
+    /* the objects the calling thread is in the middle of loading, so that an object which refers back to itself (e.g. a stream whose indirect
+    /Length is its own ref) reads null instead of recursing forever. only as deep as the objects loading one another */
+    thread_local std::vector<std::pair<const docCore*, uint64_t>> objects_loading;
+
+    struct loadingObject {
+        loadingObject(const docCore& doc, uint64_t key) { objects_loading.emplace_back(&doc, key); }
+        ~loadingObject() { objects_loading.pop_back(); }
+    };
+
+    // returns the parsed object ref points to, each object is parsed the first time it is requested & memoized. valid for as long as the document
+    const pdfObject& get_object(docCore& doc, objectRef ref) {
+        if (ref.obj_num < 0 || ref.gen_num < 0 || ref.gen_num > 0xFFFF) return null_object;
+        uint64_t key = object_key(ref);
+        if (std::find(objects_loading.begin(), objects_loading.end(), std::make_pair(static_cast<const docCore*>(&doc), key)) != objects_loading.end()) {
+            return null_object;
+        }
+
+        /* the lock only covers the cache & xref lookups & storing the result, the object is parsed (& its /ObjStm inflated) without it so that
+        pages on different threads load objects at once. recursive, as reading a linearised file's main xref can need objects. if two threads
+        miss on the same object at once both parse it & the first one stored is kept. cached objects are never modified */
+        xrefEntry entry;
+        bool in_xref = false;
+        {
+            std::lock_guard<std::recursive_mutex> lock(doc.object_mutex);
+            auto obj_iter = doc.object_cache.find(key);
+            if (obj_iter != doc.object_cache.end()) return *obj_iter->second;
+            in_xref = find_xref_entry(doc, ref, entry);
+        }
+
+        pdfObject obj;
+        if (in_xref) {
+            loadingObject loading(doc, key);
+            obj = load_object(doc, ref, entry);
+        }
+        std::lock_guard<std::recursive_mutex> lock(doc.object_mutex);
+        return *doc.object_cache.emplace(key, std::make_shared<const pdfObject>(std::move(obj))).first->second;
+    }
+
+    /* looks key up in one of the resource cache's maps, building & inserting the value on a miss. the value is built without holding the lock, if
+    two threads miss on the same resource at once both build it & the first one inserted is kept */
+    template <typename Value, typename Build>
+    std::shared_ptr<Value> find_resource(resourceCache& cache, std::unordered_map<uint64_t, std::shared_ptr<Value>>& resources, uint64_t key, Build build) {
+        {
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto resource_iter = resources.find(key);
+            if (resource_iter != resources.end()) {
+                cache.hits.fetch_add(1, std::memory_order_relaxed);
+                return resource_iter->second;
+            }
+        }
+        cache.misses.fetch_add(1, std::memory_order_relaxed);
+        std::shared_ptr<Value> resource = build();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        return resources.emplace(key, std::move(resource)).first->second;
+    }
+
+    /* font encodings. a simple font's codes are single bytes mapped to glyph names by its base encoding & /Differences, & the glyph names to
+    Unicode. a /ToUnicode CMap, when present, overrides both & is the only way to read composite fonts' 2-byte codes */
+
+    void append_utf8(char32_t code_point, std::string& out) {
+        if (code_point < 0x80) out += static_cast<char>(code_point);
+        else if (code_point < 0x800) {
+            out += static_cast<char>(0xC0 | code_point >> 6);
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else if (code_point < 0x10000) {
+            out += static_cast<char>(0xE0 | code_point >> 12);
+            out += static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | code_point >> 18);
+            out += static_cast<char>(0x80 | (code_point >> 12 & 0x3F));
+            out += static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+    }
+
+    // the code points of UTF-16BE text, as ToUnicode CMaps give it. unpaired surrogates are dropped
+    std::u32string utf16_code_points(std::string_view utf16) {
+        std::u32string code_points;
+        for (std::size_t i = 0; i + 1 < utf16.size(); i += 2) {
+            char32_t unit = static_cast<unsigned char>(utf16[i]) << 8 | static_cast<unsigned char>(utf16[i + 1]);
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < utf16.size()) {
+                char32_t low = static_cast<unsigned char>(utf16[i + 2]) << 8 | static_cast<unsigned char>(utf16[i + 3]);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    code_points += 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                }
+            }
+            else if (unit < 0xD800 || unit >= 0xE000) code_points += unit;
+        }
+        return code_points;
+    }
+
+    // the glyph names of the printable ASCII characters, from 0x20
+    const char* const ascii_glyph_names[95] = {
+        "space", "exclam", "quotedbl", "numbersign", "dollar", "percent", "ampersand", "quotesingle", "parenleft", "parenright", "asterisk",
+        "plus", "comma", "hyphen", "period", "slash", "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine", "colon",
+        "semicolon", "less", "equal", "greater", "question", "at", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P",
+        "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", "bracketleft", "backslash", "bracketright", "asciicircum", "underscore", "grave", "a",
+        "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "braceleft",
+        "bar", "braceright", "asciitilde"
+    };
+
+    // the glyph names of Latin-1's upper half, from U+00A0
+    const char* const latin1_glyph_names[96] = {
+        "nbspace", "exclamdown", "cent", "sterling", "currency", "yen", "brokenbar", "section", "dieresis", "copyright", "ordfeminine",
+        "guillemotleft", "logicalnot", "sfthyphen", "registered", "macron", "degree", "plusminus", "twosuperior", "threesuperior", "acute", "mu",
+        "paragraph", "periodcentered", "cedilla", "onesuperior", "ordmasculine", "guillemotright", "onequarter", "onehalf", "threequarters",
+        "questiondown", "Agrave", "Aacute", "Acircumflex", "Atilde", "Adieresis", "Aring", "AE", "Ccedilla", "Egrave", "Eacute", "Ecircumflex",
+        "Edieresis", "Igrave", "Iacute", "Icircumflex", "Idieresis", "Eth", "Ntilde", "Ograve", "Oacute", "Ocircumflex", "Otilde", "Odieresis",
+        "multiply", "Oslash", "Ugrave", "Uacute", "Ucircumflex", "Udieresis", "Yacute", "Thorn", "germandbls", "agrave", "aacute", "acircumflex",
+        "atilde", "adieresis", "aring", "ae", "ccedilla", "egrave", "eacute", "ecircumflex", "edieresis", "igrave", "iacute", "icircumflex",
+        "idieresis", "eth", "ntilde", "ograve", "oacute", "ocircumflex", "otilde", "odieresis", "divide", "oslash", "ugrave", "uacute",
+        "ucircumflex", "udieresis", "yacute", "thorn", "ydieresis"
+    };
+
+    struct glyphName {
+        std::string_view name;
+        char32_t unicode;
+    };
+
+    // the other glyphs of the standard Latin encodings
+    const glyphName other_glyph_names[] = {
+        { "Euro", 0x20AC }, { "quotesinglbase", 0x201A }, { "florin", 0x0192 }, { "quotedblbase", 0x201E }, { "ellipsis", 0x2026 },
+        { "dagger", 0x2020 }, { "daggerdbl", 0x2021 }, { "circumflex", 0x02C6 }, { "perthousand", 0x2030 }, { "Scaron", 0x0160 },
+        { "guilsinglleft", 0x2039 }, { "OE", 0x0152 }, { "Zcaron", 0x017D }, { "quoteleft", 0x2018 }, { "quoteright", 0x2019 },
+        { "quotedblleft", 0x201C }, { "quotedblright", 0x201D }, { "bullet", 0x2022 }, { "endash", 0x2013 }, { "emdash", 0x2014 },
+        { "tilde", 0x02DC }, { "trademark", 0x2122 }, { "scaron", 0x0161 }, { "guilsinglright", 0x203A }, { "oe", 0x0153 }, { "zcaron", 0x017E },
+        { "Ydieresis", 0x0178 }, { "fi", 0xFB01 }, { "fl", 0xFB02 }, { "ff", 0xFB00 }, { "ffi", 0xFB03 }, { "ffl", 0xFB04 }, { "fraction", 0x2044 },
+        { "dotlessi", 0x0131 }, { "Lslash", 0x0141 }, { "lslash", 0x0142 }, { "breve", 0x02D8 }, { "dotaccent", 0x02D9 }, { "ring", 0x02DA },
+        { "hungarumlaut", 0x02DD }, { "ogonek", 0x02DB }, { "caron", 0x02C7 }, { "minus", 0x2212 }, { "notequal", 0x2260 }, { "infinity", 0x221E },
+        { "lessequal", 0x2264 }, { "greaterequal", 0x2265 }, { "partialdiff", 0x2202 }, { "summation", 0x2211 }, { "product", 0x220F },
+        { "pi", 0x03C0 }, { "integral", 0x222B }, { "Omega", 0x03A9 }, { "radical", 0x221A }, { "approxequal", 0x2248 }, { "Delta", 0x2206 },
+        { "lozenge", 0x25CA }, { "space", 0x0020 }
+    };
+
+    // glyph names sorted for lookup, built once
+    const std::vector<glyphName>& get_glyph_names() {
+        static const std::vector<glyphName> names = [] {
+            std::vector<glyphName> sorted;
+            for (char32_t i = 0; i < 95; ++i) sorted.push_back({ ascii_glyph_names[i], 0x20 + i });
+            for (char32_t i = 0; i < 96; ++i) sorted.push_back({ latin1_glyph_names[i], 0xA0 + i });
+            sorted.insert(sorted.end(), std::begin(other_glyph_names), std::end(other_glyph_names));
+            std::stable_sort(sorted.begin(), sorted.end(), [](const glyphName& a, const glyphName& b) { return a.name < b.name; });
+            return sorted;
+        }();
+        return names;
+    }
+
+    // a single glyph name's code point, also reading the uniXXXX & uXXXX[XX] forms. 0 when it isn't known
+    char32_t glyph_code_point(std::string_view name) {
+        const std::vector<glyphName>& names = get_glyph_names();
+        auto name_iter = std::lower_bound(names.begin(), names.end(), name, [](const glyphName& entry, std::string_view key) { return entry.name < key; });
+        if (name_iter != names.end() && name_iter->name == name) return name_iter->unicode;
+
+        std::size_t digits_start = name.substr(0, 3) == "uni" ? 3 : (name.substr(0, 1) == "u" ? 1 : 0);
+        std::size_t digit_count = name.size() - digits_start;
+        if (digits_start == 0 || digit_count < 4 || digit_count > 6) return 0;
+        char32_t code_point = 0;
+        for (char c : name.substr(digits_start)) {
+            int digit = hex_digit_value(c);
+            if (digit < 0) return 0;
+            code_point = code_point << 4 | digit;
+        }
+        return code_point;
+    }
+
+    /* appends the text of a glyph name: a suffix after a '.' is dropped (e.g. a.sc) & ligatures' components are joined by '_' (e.g. f_f_i).
+    returns false if none of it is known */
+    bool append_glyph_text(std::string_view name, std::string& out) {
+        name = name.substr(0, name.find('.'));
+        bool found = false;
+        while (!name.empty()) {
+            std::size_t component_end = std::min(name.find('_'), name.size());
+            if (char32_t code_point = glyph_code_point(name.substr(0, component_end))) {
+                append_utf8(code_point, out);
+                found = true;
+            }
+            name = name.substr(std::min(component_end + 1, name.size()));
+        }
+        return found;
+    }
+
+    enum baseEncoding : int {
+        STANDARD_ENCODING,
+        WIN_ANSI_ENCODING,
+        MAC_ROMAN_ENCODING,
+        BUILT_IN_ENCODING // symbolic fonts' own encoding, which is read as Latin-1 as it can't be known without the font program
+    };
+
+    // the upper halves of the base encodings, as code points. 0 is unmapped
+    const char16_t standard_encoding_high[128] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0x00A1, 0x00A2, 0x00A3, 0x2044, 0x00A5, 0x0192, 0x00A7, 0x00A4, 0x0027, 0x201C, 0x00AB, 0x2039, 0x203A, 0xFB01, 0xFB02,
+        0, 0x2013, 0x2020, 0x2021, 0x00B7, 0, 0x00B6, 0x2022, 0x201A, 0x201E, 0x201D, 0x00BB, 0x2026, 0x2030, 0, 0x00BF,
+        0, 0x0060, 0x00B4, 0x02C6, 0x02DC, 0x00AF, 0x02D8, 0x02D9, 0x00A8, 0, 0x02DA, 0x00B8, 0, 0x02DD, 0x02DB, 0x02C7,
+        0x2014, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0x00C6, 0, 0x00AA, 0, 0, 0, 0, 0x0141, 0x00D8, 0x0152, 0x00BA, 0, 0, 0, 0,
+        0, 0x00E6, 0, 0, 0, 0x0131, 0, 0, 0x0142, 0x00F8, 0x0153, 0x00DF, 0, 0, 0, 0
+    };
+
+    const char16_t win_ansi_encoding_high[32] = { // 0x80-0x9F, the rest of the upper half is Latin-1
+        0x20AC, 0, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0, 0x017D, 0,
+        0, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0, 0x017E, 0x0178
+    };
+
+    const char16_t mac_roman_encoding_high[128] = {
+        0x00C4, 0x00C5, 0x00C7, 0x00C9, 0x00D1, 0x00D6, 0x00DC, 0x00E1, 0x00E0, 0x00E2, 0x00E4, 0x00E3, 0x00E5, 0x00E7, 0x00E9, 0x00E8,
+        0x00EA, 0x00EB, 0x00ED, 0x00EC, 0x00EE, 0x00EF, 0x00F1, 0x00F3, 0x00F2, 0x00F4, 0x00F6, 0x00F5, 0x00FA, 0x00F9, 0x00FB, 0x00FC,
+        0x2020, 0x00B0, 0x00A2, 0x00A3, 0x00A7, 0x2022, 0x00B6, 0x00DF, 0x00AE, 0x00A9, 0x2122, 0x00B4, 0x00A8, 0x2260, 0x00C6, 0x00D8,
+        0x221E, 0x00B1, 0x2264, 0x2265, 0x00A5, 0x00B5, 0x2202, 0x2211, 0x220F, 0x03C0, 0x222B, 0x00AA, 0x00BA, 0x03A9, 0x00E6, 0x00F8,
+        0x00BF, 0x00A1, 0x00AC, 0x221A, 0x0192, 0x2248, 0x2206, 0x00AB, 0x00BB, 0x2026, 0x00A0, 0x00C0, 0x00C3, 0x00D5, 0x0152, 0x0153,
+        0x2013, 0x2014, 0x201C, 0x201D, 0x2018, 0x2019, 0x00F7, 0x25CA, 0x00FF, 0x0178, 0x2044, 0x00A4, 0x2039, 0x203A, 0xFB01, 0xFB02,
+        0x2021, 0x00B7, 0x201A, 0x201E, 0x2030, 0x00C2, 0x00CA, 0x00C1, 0x00CB, 0x00C8, 0x00CD, 0x00CE, 0x00CF, 0x00CC, 0x00D3, 0x00D4,
+        0, 0x00D2, 0x00DA, 0x00DB, 0x00D9, 0x0131, 0x02C6, 0x02DC, 0x00AF, 0x02D8, 0x02D9, 0x02DA, 0x00B8, 0x02DD, 0x02DB, 0x02C7
+    };
+
+    // the code point a base encoding maps code to, 0 when unmapped
+    char32_t base_encoding_code_point(baseEncoding encoding, uint8_t code) {
+        if (encoding == BUILT_IN_ENCODING) return code;
+        if (code >= 0x80) {
+            if (encoding == STANDARD_ENCODING) return standard_encoding_high[code - 0x80];
+            if (encoding == MAC_ROMAN_ENCODING) return mac_roman_encoding_high[code - 0x80];
+            return code < 0xA0 ? win_ansi_encoding_high[code - 0x80] : code;
+        }
+        if (code < 0x20 || code == 0x7F) return 0;
+        // the standard encoding has curly quotes where ASCII has straight ones
+        if (encoding == STANDARD_ENCODING && code == 0x27) return 0x2019;
+        if (encoding == STANDARD_ENCODING && code == 0x60) return 0x2018;
+        return code;
+    }
+
+    baseEncoding get_base_encoding(std::string_view name, baseEncoding default_encoding) {
+        if (name == "/WinAnsiEncoding") return WIN_ANSI_ENCODING;
+        if (name == "/MacRomanEncoding") return MAC_ROMAN_ENCODING;
+        if (name == "/StandardEncoding") return STANDARD_ENCODING;
+        return default_encoding;
+    }
+
+    // appends text to the font's pool, returning where it is
+    codeMapping add_font_text(fontObject& font, std::string_view text) {
+        codeMapping mapping{ static_cast<uint32_t>(font.text_pool.size()), static_cast<uint32_t>(text.size()) };
+        font.text_pool += text;
+        return mapping;
+    }
+
+    // fills a simple font's 1-byte table from its base encoding & /Differences
+    void load_simple_encoding(fontObject& font, const pdfObject& font_obj) {
+        // fonts without an /Encoding use the standard encoding, unless they are symbolic (/Flags bit 3) & have their own
+        bool symbolic = font_obj.get("/FontDescriptor").get_int("/Flags") & 4;
+        baseEncoding default_encoding = symbolic ? BUILT_IN_ENCODING : STANDARD_ENCODING;
+        const pdfObject& encoding = font_obj.get("/Encoding");
+        baseEncoding base = encoding.type == OBJ_NAME ? get_base_encoding(encoding.text, default_encoding)
+            : get_base_encoding(encoding.get_name("/BaseEncoding"), default_encoding);
+
+        std::array<std::string, 256> glyph_text;
+        for (int code = 0; code < 256; ++code) {
+            if (char32_t code_point = base_encoding_code_point(base, static_cast<uint8_t>(code))) append_utf8(code_point, glyph_text[code]);
+        }
+        // /Differences is a list of codes each followed by the glyph names of it & the codes after it
+        const pdfObject& differences = encoding.get("/Differences");
+        long long code = 0;
+        for (const pdfObject& element : differences.array) {
+            const pdfObject& value = resolve(element);
+            if (value.type == OBJ_INTEGER) code = value.int_value;
+            else if (value.type == OBJ_NAME) {
+                if (code >= 0 && code < 256) {
+                    glyph_text[code].clear();
+                    append_glyph_text(value.text.substr(1), glyph_text[code]);
+                }
+                ++code;
+            }
+        }
+        for (int i = 0; i < 256; ++i) font.byte_codes[i] = add_font_text(font, glyph_text[i]);
+    }
+
+    // a hex string's bytes as a big-endian code, false when it's wider than the font's codes
+    bool read_code(std::string_view hex, int code_length, uint32_t& code) {
+        std::string bytes;
+        decode_hex_string(hex, bytes);
+        if (bytes.size() > static_cast<std::size_t>(code_length)) return false;
+        code = 0;
+        for (char byte : bytes) code = code << 8 | static_cast<unsigned char>(byte);
+        return true;
+    }
+
+    /* fills a font's tables from its /ToUnicode CMap's bfchar & bfrange mappings, over whatever the encoding mapped. other CMap operators are
+    skipped, the code length comes from the font type rather than the CMap's codespace ranges */
+    void load_to_unicode(fontObject& font, const pdfObject& cmap_stream) {
+        std::string cmap;
+        decode_stream(cmap_stream, cmap);
+        lexer lex(cmap, 0, false);
+
+        // a code's text, written to the 1-byte table or collected as a single-code range
+        auto map_code = [&font](uint32_t code, std::string_view text) {
+            if (font.code_length == 1 && code < 256) font.byte_codes[code] = add_font_text(font, text);
+            else if (font.code_length == 2 && code < 0x10000) {
+                font.code_ranges.push_back({ static_cast<uint16_t>(code), static_cast<uint16_t>(code), 0, add_font_text(font, text) });
+            }
+        };
+        auto hex_code_points = [](std::string_view hex) {
+            std::string utf16;
+            decode_hex_string(hex, utf16);
+            return utf16_code_points(utf16);
+        };
+        auto utf8_text = [](const std::u32string& code_points) {
+            std::string text;
+            for (char32_t code_point : code_points) append_utf8(code_point, text);
+            return text;
+        };
+
+        for (token tok = lex.next(); tok.type != TOKEN_END; tok = lex.next()) {
+            if (is_keyword(tok, "beginbfchar")) {
+                // <code> <text> pairs
+                for (token src = lex.next(); src.type == TOKEN_HEX_STRING; src = lex.next()) {
+                    token dst = lex.next();
+                    uint32_t code = 0;
+                    if (!read_code(src.text, font.code_length, code)) continue;
+                    std::string text;
+                    if (dst.type == TOKEN_HEX_STRING) text = utf8_text(hex_code_points(dst.text));
+                    else if (dst.type == TOKEN_NAME) append_glyph_text(dst.text.substr(1), text);
+                    map_code(code, text);
+                }
+            }
+            else if (is_keyword(tok, "beginbfrange")) {
+                // <first> <last> followed by either the first code's text, the last code point of which counts up, or an array of each code's text
+                for (token first = lex.next(); first.type == TOKEN_HEX_STRING; first = lex.next()) {
+                    token last = lex.next();
+                    token dst = lex.next();
+                    uint32_t first_code = 0;
+                    uint32_t last_code = 0;
+                    bool fits = read_code(first.text, font.code_length, first_code) && last.type == TOKEN_HEX_STRING && read_code(last.text, font.code_length, last_code);
+                    if (!fits || last_code < first_code || last_code - first_code > 0xFFFF) {
+                        if (dst.type == TOKEN_ARRAY_BEGIN) while (lex.next().type == TOKEN_HEX_STRING) {}
+                        continue;
+                    }
+
+                    // 64-bit counters so a range ending at the widest code can't wrap
+                    if (dst.type == TOKEN_ARRAY_BEGIN) {
+                        uint64_t code = first_code;
+                        for (token element = lex.next(); element.type == TOKEN_HEX_STRING; element = lex.next(), ++code) {
+                            if (code <= last_code) map_code(static_cast<uint32_t>(code), utf8_text(hex_code_points(element.text)));
+                        }
+                        continue;
+                    }
+                    if (dst.type != TOKEN_HEX_STRING) continue;
+                    std::u32string code_points = hex_code_points(dst.text);
+                    if (code_points.empty()) continue;
+                    if (font.code_length == 2 && code_points.size() == 1 && last_code < 0x10000) {
+                        font.code_ranges.push_back({ static_cast<uint16_t>(first_code), static_cast<uint16_t>(last_code), code_points[0], { 0, 0 } });
+                        continue;
+                    }
+                    for (uint64_t code = first_code; code <= last_code; ++code, ++code_points.back()) map_code(static_cast<uint32_t>(code), utf8_text(code_points));
+                }
+            }
+        }
+    }
+
+    // the part of a range from first to last, its counted-up code points shifted to match
+    codeRange split_code_range(const codeRange& range, uint32_t first, uint32_t last) {
+        codeRange piece = range;
+        piece.first = static_cast<uint16_t>(first);
+        piece.last = static_cast<uint16_t>(last);
+        piece.unicode += first - range.first; // only counting ranges span more than one code, so only they're split
+        return piece;
+    }
+
+    /* replaces ranges in mapping order with sorted, non-overlapping ones. a later mapping of a code overrides earlier ones, so whatever part of
+    an earlier range it covers is cut out & the parts either side of it are kept */
+    void flatten_code_ranges(std::vector<codeRange>& ranges) {
+        std::map<uint16_t, codeRange> pieces; // keyed by first code
+        for (const codeRange& range : ranges) {
+            auto piece = pieces.upper_bound(range.first);
+            if (piece != pieces.begin() && std::prev(piece)->second.last >= range.first) --piece;
+            while (piece != pieces.end() && piece->second.first <= range.last) {
+                codeRange covered = piece->second;
+                piece = pieces.erase(piece);
+                if (covered.first < range.first) pieces.emplace(covered.first, split_code_range(covered, covered.first, range.first - 1u));
+                if (covered.last > range.last) pieces.emplace(range.last + 1u, split_code_range(covered, range.last + 1u, covered.last));
+            }
+            pieces.emplace(range.first, range);
+        }
+        ranges.clear();
+        for (const auto& [first, piece] : pieces) ranges.push_back(piece);
+    }
+
+    void fontObject::decode(std::string_view codes, std::string& out) const {
+        if (code_length == 1) {
+            for (char code : codes) {
+                const codeMapping& mapping = byte_codes[static_cast<unsigned char>(code)];
+                out.append(text_pool, mapping.offset, mapping.length);
+            }
+            return;
+        }
+        for (std::size_t i = 0; i + 1 < codes.size(); i += 2) {
+            uint16_t code = static_cast<uint16_t>(static_cast<unsigned char>(codes[i]) << 8 | static_cast<unsigned char>(codes[i + 1]));
+            // the range starting at or before code
+            auto range = std::upper_bound(code_ranges.begin(), code_ranges.end(), code, [](uint16_t value, const codeRange& entry) { return value < entry.first; });
+            if (range == code_ranges.begin() || (--range)->last < code) {
+                append_utf8(0xFFFD, out);
+                continue;
+            }
+            // a single code with no text has neither a pool entry nor a code point, where a range may count up from U+0000
+            if (range->text.length > 0 || (range->unicode == 0 && range->first == range->last)) out.append(text_pool, range->text.offset, range->text.length);
+            else append_utf8(range->unicode + (code - range->first), out);
+        }
+    }
+
+    fontSubtype get_font_subtype(std::string_view name) {
+        if (name == "/Type1") return FONT_TYPE1;
+        if (name == "/MMType1") return FONT_MM_TYPE1;
+        if (name == "/TrueType") return FONT_TRUETYPE;
+        if (name == "/Type3") return FONT_TYPE3;
+        if (name == "/Type0") return FONT_TYPE0;
+        return FONT_UNKNOWN;
+    }
+
+    std::shared_ptr<fontObject> get_font(docCore& doc, objectRef font_ref) {
+        if (font_ref.obj_num < 0 || font_ref.gen_num < 0 || font_ref.gen_num > 0xFFFF) return nullptr;
+        return find_resource(doc.resources, doc.resources.fonts, object_key(font_ref), [&] {
+            const pdfObject& font_obj = get_object(doc, font_ref);
+            std::shared_ptr<fontObject> font = std::make_shared<fontObject>();
+            font->font_name = std::string(font_obj.get_name("/BaseFont"));
+            font->subtype = get_font_subtype(font_obj.get_name("/Subtype"));
+            // composite fonts are read as 2-byte codes, which is what Identity-H & nearly every other CMap they use has
+            if (font->subtype == FONT_TYPE0) font->code_length = 2;
+            else load_simple_encoding(*font, font_obj);
+
+            const pdfObject& to_unicode = font_obj.get("/ToUnicode");
+            if (to_unicode.type == OBJ_STREAM) load_to_unicode(*font, to_unicode);
+            flatten_code_ranges(font->code_ranges);
+            return font;
+        });
+    }
+
+    std::shared_ptr<const xObjectInfo> get_x_obj_info(docCore& doc, objectRef x_obj_ref) {
+        if (x_obj_ref.obj_num < 0 || x_obj_ref.gen_num < 0 || x_obj_ref.gen_num > 0xFFFF) return std::make_shared<const xObjectInfo>();
+        return find_resource(doc.resources, doc.resources.x_objects, object_key(x_obj_ref), [&] {
+            const pdfObject& x_obj = get_object(doc, x_obj_ref);
+            auto info = std::make_shared<xObjectInfo>();
+            info->subtype = std::string(x_obj.get_name("/Subtype"));
+            if (info->subtype == "/Image") {
+                info->width = static_cast<int>(x_obj.get_int("/Width"));
+                info->height = static_cast<int>(x_obj.get_int("/Height"));
+                info->bits_per_component = static_cast<int>(x_obj.get_int("/BitsPerComponent"));
+                std::string_view colour_space = x_obj.get_name("/ColorSpace");
+                if (colour_space == "/DeviceRGB") info->clr_space = DEVICE_RGB;
+                if (colour_space == "/DeviceCMYK") info->clr_space = DEVICE_CMYK;
+                info->components = colour_space == "/DeviceCMYK" ? 4 : (colour_space == "/DeviceGray" ? 1 : 3);
+                info->interpolate = x_obj.get_bool("/Interpolate");
+            }
+            return std::shared_ptr<const xObjectInfo>(std::move(info));
+        });
+    }
+
+    std::vector<objectRef> parse_obj_ref_array(const pdfObject& array) {
+        std::vector<objectRef> objs;
+        for (const pdfObject& element : array.array) {
+            if (element.type == OBJ_REF) objs.push_back(element.ref);
+        }
+        return objs;
+    }
+
+    // maps each key of dict (without its '/') to the ref it holds, keys holding direct values are skipped
+    std::map<std::string, objectRef> parse_obj_ref_dict(const pdfObject& dict) {
+        std::map<std::string, objectRef> obj_map;
+        for (const dictEntry& entry : dict.dict) {
+            if (entry.value.type == OBJ_REF) obj_map.emplace(std::string(entry.key.substr(1)), entry.value.ref);
+        }
+        return obj_map;
+    }
+
+    // returns the integers of array, non-integer elements are skipped
+    std::vector<long long> parse_int_array(const pdfObject& array) {
+        std::vector<long long> values;
+        for (const pdfObject& element : array.array) {
+            if (element.type == OBJ_INTEGER) values.push_back(element.int_value);
+        }
+        return values;
+    }
+
+    std::size_t get_xref_table_position(const docCore& doc) {
+        return doc.ref_struct.startxref;
+    }
+
+    rect parse_rect(const pdfObject& array) {
+        rect parsed_rect{};
+        // both integers & decimal numbers are allowed
+        if (array.array.size() < 4) return parsed_rect;
+        for (std::size_t i = 0; i < 4; ++i) {
+            if (!array.array[i].is_number()) return parsed_rect;
+        }
+        parsed_rect.bottom_left.x = array.array[0].real_value;
+        parsed_rect.bottom_left.y = array.array[1].real_value;
+        parsed_rect.top_right.x = array.array[2].real_value;
+        parsed_rect.top_right.y = array.array[3].real_value;
+        return parsed_rect;
+    }
+
+    
+    // returns the line starting at pos (without its EOL marker) & moves pos past it, works on views so the document is never copied
+    bool next_line(std::string_view look_in, std::size_t& pos, std::string_view& line) {
+        if (pos >= look_in.size()) return false;
+        std::size_t line_end = look_in.find_first_of("\r\n", pos);
+        if (line_end == std::string_view::npos) line_end = look_in.size();
+        line = look_in.substr(pos, line_end - pos);
+        pos = line_end;
+        if (pos < look_in.size() && look_in[pos] == '\r') ++pos;
+        if (pos < look_in.size() && look_in[pos] == '\n') ++pos;
+        return true;
+    }
+
+    // for old-style text xref tables, use parse_xref_stream() for the newer xref streams introduced in PDF 1.5
+    void parse_xref_table(docCore& doc, std::size_t xref_pos) {
+        std::string_view contents = doc.doc_contents;
+        std::size_t pos = xref_pos; // go to xref position
+        std::string_view line;
+
+        next_line(contents, pos, line);  // skip xref symbol
+
+        while (next_line(contents, pos, line)) {
+            if (line == "trailer"  || line == "xref") break;
+
+            // Parse subsection header, this tells us the number of the first object in the xref & the amount of objects in the xref
+            std::size_t line_pos = 0;
+            long long first_obj_num = read_uint(line, line_pos);
+            long long obj_count = read_uint(line, line_pos);
+            if (first_obj_num < 0 || obj_count < 0) break; // not a subsection header, so the table is over
+            doc.object_refs.reserve(static_cast<std::size_t>(first_obj_num + obj_count));
+
+
+            for (long long i = 0; i < obj_count && next_line(contents, pos, line); ++i) {
+                // each entry is '<10 digit offset> <5 digit gen num> <n or f>'
+                xrefEntry entry{};
+                line_pos = 0;
+                long long offset = read_uint(line, line_pos);
+                long long gen_num = read_uint(line, line_pos);
+                while (line_pos < line.size() && line[line_pos] == ' ') ++line_pos;
+                if (offset < 0 || gen_num < 0 || line_pos >= line.size()) continue;
+                entry.object_offset = static_cast<std::size_t>(offset);
+                entry.gen_num = static_cast<int>(gen_num);
+                entry.status = line[line_pos];
+
+                doc.object_refs.add(static_cast<int>(first_obj_num + i), entry); // each line of a subsection is the next object number
+            }
+            
+        }
+    }
+
+    // reads the ID, an array of two strings which are normally written in hex
+    void read_doc_id(const pdfObject& trailer, std::array<std::string, 2>& doc_id) {
+        const pdfObject& id = trailer.get("/ID");
+        for (std::size_t i = 0; i < id.array.size() && i < doc_id.size(); ++i) {
+            if (id.array[i].type != OBJ_STRING) break;
+            doc_id[i] = std::string(id.array[i].text);
+        }
+    }
+
+    // reads the document-level keys shared by trailers & xref streams
+    void parse_doc_trailer(docCore& doc, const pdfObject& trailer) {
+        const pdfObject* root = trailer.find("/Root");
+        if (root && root->type == OBJ_REF) doc.ref_struct.root_object_ref = root->ref;
+
+        // Parse Info object number
+        const pdfObject* info = trailer.find("/Info");
+        if (info && info->type == OBJ_REF) doc.ref_struct.info_object_ref = info->ref;
+
+        read_doc_id(trailer, doc.ref_struct.id);
+    }
+
+    /* the decompressed stream is non-readable binary data, each entry is /W[0] bytes of type, /W[1] bytes of field_1 & /W[2] bytes of field_2,
+    all big-endian. they are decoded in one pass straight into the xref index, object numbers coming from the /Index subsections in order.
+
+    type refers to the obj's current type, 0 means it represents a free obj, 1 an in-use obj & 2 an obj still compressed in a /ObjStm
+    for entries where type = 0:
+     field_1 = obj num of next free obj
+     field_2 = gen_num
+    for entries where type = 1:
+     field_1 = obj's byte offset
+     field_2 = gen_num
+    for entries where type = 2:
+     field_1 = the obj number of the /ObjStm where the object is stored, gen_num is always assumed to be 0
+     field_2 = object's index within the /ObjStm
+    */
+    void decode_xref_entries(docCore& doc, const std::vector<uint8_t>& entries, const xrefStreamInfo& stream_info) {
+        int type_width = stream_info.width[0];
+        int field_1_width = stream_info.width[1];
+        int field_2_width = stream_info.width[2];
+        std::size_t entry_size = type_width + field_1_width + field_2_width;
+        if (entry_size == 0) return;
+
+        auto read_field = [&entries](std::size_t& pos, int width) {
+            uint64_t value = 0;
+            for (int i = 0; i < width; ++i) value = (value << 8) | entries[pos++];
+            return value;
+        };
+
+        std::size_t pos = 0;
+        for (const auto& subsection : stream_info.index) {
+            doc.object_refs.reserve(static_cast<std::size_t>(subsection[0]) + subsection[1]);
+            for (int i = 0; i < subsection[1] && pos + entry_size <= entries.size(); ++i) {
+                uint64_t type = type_width == 0 ? 1 : read_field(pos, type_width); // the type defaults to 1 when its width is 0
+                uint64_t field_1 = read_field(pos, field_1_width);
+                uint64_t field_2 = read_field(pos, field_2_width);
+
+                xrefEntry entry{};
+                switch (type) {
+                case 0: // Free object
+                    entry.status = 'f';
+                    entry.gen_num = static_cast<int>(field_2);
+                    break;
+                case 1: // Used object
+                    entry.status = 'n';
+                    entry.object_offset = static_cast<std::size_t>(field_1);
+                    entry.gen_num = static_cast<int>(field_2);
+                    break;
+                case 2: // compressed object, resolved lazily from its /ObjStm by get_object()
+                    entry.status = 'c';
+                    entry.obj_stm_num = static_cast<int>(field_1);
+                    entry.obj_stm_index = static_cast<int>(field_2);
+                    break;
+                default: // other types are reserved & must be treated as refs to the null object
+                    continue;
+                }
+                doc.object_refs.add(subsection[0] + i, entry);
+            }
+        }
+    }
+
+    /* xref streams are a compressed & compacted form of the old-style xref tables introduced in 1.5, they also allow for object compression.
+    xref_stream is the xref stream object, returns the offset of the previous xref section (/Prev) or npos if this is the oldest one */
+    std::size_t parse_xref_stream(docCore& doc, const pdfObject& xref_stream) {
+        xrefStreamInfo stream_info{};
+
+        std::vector<long long> width = parse_int_array(xref_stream.get("/W"));
+        if (width.size() == 3) {
+            stream_info.width = { static_cast<int>(width[0]), static_cast<int>(width[1]), static_cast<int>(width[2]) };
+        }
+
+        // /Index holds a pair of numbers per subsection, when missing the stream has one subsection with every object up to /Size
+        std::vector<long long> index = parse_int_array(xref_stream.get("/Index"));
+        for (std::size_t i = 0; i + 1 < index.size(); i += 2) {
+            stream_info.index.push_back({ static_cast<int>(index[i]), static_cast<int>(index[i + 1]) });
+        }
+        if (stream_info.index.empty()) stream_info.index.push_back({ 0, static_cast<int>(xref_stream.get_int("/Size")) });
+
+        // the entries are decoded by the stream's filters, normally /FlateDecode with a PNG predictor
+        std::vector<uint8_t> entries;
+        decode_stream(xref_stream, entries);
+        decode_xref_entries(doc, entries, stream_info);
+
+        long long prev = xref_stream.get_int("/Prev", -1);
+        if (prev >= 0) return static_cast<std::size_t>(prev);
+        return std::string_view::npos;
+    }
 
-        z_stream zs{};
-        zs.zalloc = Z_NULL;
-        zs.zfree = Z_NULL;
-        zs.opaque = Z_NULL;
-        zs.avail_in = 0;
-        zs.next_in = Z_NULL;
+    /* reads the xref section at xref_pos, either a table & its trailer or an xref stream, & returns the offset of the previous section (/Prev) or
+    npos if it is the oldest or isn't an xref section at all. the trailer keys (/Root, /Info & /ID) are only taken from the newest section. sections
+    already in visited are skipped, the ones read are added to it */
+    std::size_t parse_xref_section(docCore& doc, std::size_t xref_pos, bool newest, std::vector<std::size_t>& visited) {
+        std::string_view contents = fetch(doc, xref_pos, initial_fetch_window);
+        while (xref_pos < contents.size() && is_pdf_whitespace(contents[xref_pos])) ++xref_pos;
+        if (xref_pos >= contents.size() || std::find(visited.begin(), visited.end(), xref_pos) != visited.end()) return std::string_view::npos;
+        visited.push_back(xref_pos); // guards against /Prev loops in damaged files
+
+        if (contents.substr(xref_pos, 4) != "xref") {
+            pdfObject xref_stream = parse_indirect_object(doc, xref_pos);
+            if (xref_stream.get_name("/Type") != "/XRef") return std::string_view::npos;
+            if (newest) parse_doc_trailer(doc, xref_stream);
+            return parse_xref_stream(doc, xref_stream);
+        }
 
-        int ret = inflateInit2(&zs, 15 + 32); // Allow zlib and gzip decoding
-        if (ret != Z_OK) {
-            throw std::runtime_error("inflateInit2 failed");
+        // the trailer follows the table, which only holds numbers & entry types, so the first 'trailer' after it is its own
+        contents = fetch_until(doc, xref_pos, "trailer");
+        std::size_t trailer_pos = contents.find("trailer", xref_pos);
+        if (trailer_pos == std::string_view::npos) {
+            parse_xref_table(doc, xref_pos);
+            return std::string_view::npos;
+        }
+        pdfObject trailer = parse_fetched(doc, trailer_pos + 7, [&doc](lexer& trailer_lexer) { return parse_object(trailer_lexer, &doc); });
+        if (newest) parse_doc_trailer(doc, trailer);
+
+        /* a hybrid file's trailer points (/XRefStm) at an xref stream holding the objects compressed into /ObjStm. it belongs to the same update
+        as the table, which lists those objects as free or not at all for older readers, so the stream is read first & its entries win */
+        long long xref_stm = trailer.get_int("/XRefStm", -1);
+        if (xref_stm >= 0 && std::find(visited.begin(), visited.end(), static_cast<std::size_t>(xref_stm)) == visited.end()) {
+            visited.push_back(static_cast<std::size_t>(xref_stm));
+            pdfObject xref_stream = parse_indirect_object(doc, static_cast<std::size_t>(xref_stm));
+            if (xref_stream.get_name("/Type") == "/XRef") parse_xref_stream(doc, xref_stream);
         }
+        parse_xref_table(doc, xref_pos);
 
-        std::string decompressed_stream;
-        std::vector<char> out_buffer(32768);
+        long long prev = trailer.get_int("/Prev", -1);
+        if (prev >= 0) return static_cast<std::size_t>(prev);
+        return std::string_view::npos;
+    }
 
-        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(obj_stream.data()));
-        zs.avail_in = static_cast<uInt>(obj_stream.size());
+    /* reads the chain of xref sections starting at xref_pos, the newest, following /Prev back to the oldest. incremental updates each append a
+    section, & as the index keeps the first entry it is given for an object, the newest entry for every object wins. each section is read once.
+    returns false if xref_pos isn't an xref section */
+    bool parse_xref_chain(docCore& doc, std::size_t xref_pos) {
+        std::vector<std::size_t> visited;
+        xref_pos = parse_xref_section(doc, xref_pos, true, visited);
+        if (visited.empty()) return false;
+        while (xref_pos != std::string_view::npos) xref_pos = parse_xref_section(doc, xref_pos, false, visited);
+        return true;
+    }
 
-        do {
-            zs.next_out = reinterpret_cast<Bytef*>(out_buffer.data());
-            zs.avail_out = static_cast<uInt>(out_buffer.size());
+    /* reads the main xref of a linearised file, which holds every object outside the first page. it is the oldest section, so the first-page
+    entries already in the index take precedence. called by find_xref_entry() with the object mutex held */
+    void load_deferred_xref(docCore& doc) {
+        std::size_t xref_pos = doc.deferred_xref_pos;
+        doc.deferred_xref_pos = std::string_view::npos;
+        std::vector<std::size_t> visited;
+        while (xref_pos != std::string_view::npos) xref_pos = parse_xref_section(doc, xref_pos, false, visited);
+    }
 
-            ret = inflate(&zs, Z_NO_FLUSH);
-            if (ret == Z_STREAM_ERROR || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
-                inflateEnd(&zs);
-                throw std::runtime_error("inflate failed");
+    // reads the big-endian bit fields hint tables are packed into. reading past the end gives 0 bits & sets overrun()
+    class bitReader {
+    public:
+        explicit bitReader(std::string_view data) : data(data) {}
+
+        uint64_t read(int bits) {
+            uint64_t value = 0;
+            for (int i = 0; i < bits; ++i) {
+                std::size_t byte_pos = bit_pos >> 3;
+                if (byte_pos >= data.size()) {
+                    read_past_end = true;
+                    return 0;
+                }
+                value = (value << 1) | ((static_cast<uint8_t>(data[byte_pos]) >> (7 - (bit_pos & 7))) & 1);
+                ++bit_pos;
             }
+            return value;
+        }
 
-            decompressed_stream.insert(decompressed_stream.end(), out_buffer.begin(), out_buffer.begin() + out_buffer.size() - zs.avail_out);
-        } while (ret != Z_STREAM_END);
+        // each item of the per-page entries starts on a byte boundary
+        void align() { bit_pos = (bit_pos + 7) & ~std::size_t(7); }
 
-        inflateEnd(&zs);
+        bool overrun() const { return read_past_end; }
 
-        return decompressed_stream;
-    }
+    private:
+        std::string_view data;
+        std::size_t bit_pos = 0;
+        bool read_past_end = false;
+    };
 
-    int get_tag_value(std::size_t tag_pos, const std::string& look_in) {
-        while (!std::isdigit(look_in[tag_pos])) ++tag_pos;
-        std::size_t tag_end = look_in.find_first_of("/", tag_pos);
-        return std::stoi(look_in.substr(tag_pos, tag_end - tag_pos));
+    /* reads the page offset hint table at the start of the primary hint stream, giving every page's object number & byte range. the first page's
+    page object is /O & the second page's is object 1, each later page following on from the objects of the page before it. offsets in the table
+    are written as if the hint stream weren't in the file, so those past it are moved by its length. page_hints stays empty if the table is unusable */
+    void load_page_hints(docCore& doc) {
+        linearisationInfo& lin = doc.linearisation;
+        std::call_once(lin.hints_once, [&] {
+            pdfObject hint_stream = parse_indirect_object(doc, lin.hint_offset);
+            if (hint_stream.type != OBJ_STREAM || lin.page_count <= 0) return;
+            std::string hints;
+            decode_stream(hint_stream, hints);
+
+            bitReader bits(hints);
+            uint64_t least_obj_count = bits.read(32);
+            uint64_t first_page_offset = bits.read(32);
+            int obj_count_bits = static_cast<int>(bits.read(16));
+            uint64_t least_length = bits.read(32);
+            int length_bits = static_cast<int>(bits.read(16));
+            bits.read(32 + 16 + 32 + 16 + 16 + 16 + 16 + 16); // content stream & shared object items, which aren't needed to find pages
+            if (obj_count_bits > 32 || length_bits > 32) return;
+
+            std::size_t page_count = static_cast<std::size_t>(lin.page_count);
+            if (page_count * (obj_count_bits + length_bits) > hints.size() * 8) return; // a damaged /N, don't allocate for it
+            std::vector<uint64_t> obj_counts(page_count);
+            std::vector<uint64_t> lengths(page_count);
+            for (uint64_t& obj_count : obj_counts) obj_count = least_obj_count + bits.read(obj_count_bits);
+            bits.align();
+            for (uint64_t& length : lengths) length = least_length + bits.read(length_bits);
+            if (bits.overrun()) return;
+
+            uint64_t obj_num = 1;
+            uint64_t offset = first_page_offset;
+            lin.page_hints.reserve(page_count);
+            for (std::size_t i = 0; i < page_count; ++i) {
+                pageHint hint;
+                hint.first_obj_num = i == 0 ? lin.first_page_obj_num : static_cast<int>(obj_num);
+                hint.offset = static_cast<std::size_t>(offset >= lin.hint_offset ? offset + lin.hint_length : offset);
+                hint.length = static_cast<std::size_t>(lengths[i]);
+                lin.page_hints.push_back(hint);
+                if (i > 0) obj_num += obj_counts[i];
+                offset += lengths[i];
+            }
+        });
     }
 
-    bool get_tag_bool_value(std::size_t tag_pos, const std::string& look_in) {
-        if (look_in.find("true", tag_pos) != std::string::npos) return true;
-        else return false;
+    /* reads the start of a linearised file: its linearisation dictionary, the first-page xref right after it & that xref's trailer. the main xref
+    (the trailer's /Prev) is left until an object it holds is needed. returns false if the file isn't usable as linearised, e.g. because it has
+    been updated since it was written, in which case it is parsed like any other */
+    bool load_linearised_document(docCore& doc, const pdfObject& linearisation_dict, std::size_t first_xref_pos) {
+        // an incremental update appends to the file, so its length no longer matches /L & the linearisation data is stale
+        long long file_length = linearisation_dict.get_int("/L", -1);
+        if (file_length < 0 || static_cast<std::size_t>(file_length) != doc.doc_contents.size()) return false;
+
+        linearisationInfo& lin = doc.linearisation;
+        std::vector<long long> hint_stream = parse_int_array(linearisation_dict.get("/H"));
+        long long first_page_obj_num = linearisation_dict.get_int("/O", -1);
+        long long page_count = linearisation_dict.get_int("/N", -1);
+        if (hint_stream.size() < 2 || hint_stream[0] < 0 || hint_stream[1] < 0 || first_page_obj_num < 0 || page_count < 1) return false;
+        lin.hint_offset = static_cast<std::size_t>(hint_stream[0]);
+        lin.hint_length = static_cast<std::size_t>(hint_stream[1]);
+        lin.first_page_obj_num = static_cast<int>(first_page_obj_num);
+        lin.page_count = static_cast<int>(page_count);
+        lin.first_page_end = static_cast<std::size_t>(std::max(0LL, linearisation_dict.get_int("/E")));
+
+        std::vector<std::size_t> visited;
+        doc.deferred_xref_pos = parse_xref_section(doc, first_xref_pos, true, visited);
+        if (visited.empty()) return false;
+
+        /* the page count comes from /N rather than the page tree, whose nodes are stored after the first page. the catalog is in the first
+        page's section, so finding the tree's root costs nothing extra */
+        const pdfObject* pages_root = get_object(doc, doc.ref_struct.root_object_ref).find("/Pages");
+        if (!pages_root || pages_root->type != OBJ_REF) return false;
+        doc.objects_root.pages_root = pages_root->ref;
+        doc.objects_root.page_count = lin.page_count;
+        lin.linearised = true;
+        return true;
     }
 
+    // a node sets the attributes it has for itself & every page below it, overriding what it inherited
+    void inherit_page_attributes(pageEntry& entry, const pdfObject& node) {
+        if (const pdfObject* resources = node.find("/Resources")) entry.resources = &resolve(*resources);
+        if (const pdfObject* media_box = node.find("/MediaBox")) entry.media_box = &resolve(*media_box);
+        if (const pdfObject* crop_box = node.find("/CropBox")) entry.crop_box = &resolve(*crop_box);
+        if (const pdfObject* rotate = node.find("/Rotate")) entry.rotate = &resolve(*rotate);
+    }
 
-
-    std::string get_tag_type(std::size_t tag_pos, const std::string& look_in) {
-        std::size_t type_pos = look_in.find_first_of("/", tag_pos + 1);
-        std::size_t type_end = look_in.find_first_of("/", type_pos + 1);
-        return look_in.substr(type_pos, type_end - type_pos);
+    // the page tree's leaves are /Type /Page, some writers leave the type out, in which case any node without /Kids is a page
+    bool is_page_node(const pdfObject& node) {
+        std::string_view type = node.get_name("/Type");
+        if (type == "/Page") return true;
+        if (type == "/Pages") return false;
+        return node.get("/Kids").type != OBJ_ARRAY;
     }
 
-    std::size_t parse_obj_ref(const std::string& ref_tag, const std::string& look_in) {
-        boost::regex ref_regex(ref_tag + R"(\s+(\d+)\s+(\d+)\s+R)");
-        boost::smatch ref_match;
-        boost::regex_search(look_in, ref_match, ref_regex);
-        return doc_core.object_refs[std::stoi(ref_match[1])][std::stoi(ref_match[2])].object_offset;
+    const int max_page_tree_depth = 64; // deeper trees only occur in damaged or malicious files
+
+    /* resolves a page's inherited attributes by walking up its /Parent chain, rather than down from the root. linearised files normally copy them
+    into every page object, so unless all_attributes is set the parents (which are stored after the first page) are only read when a page lacks
+    /Resources or /MediaBox */
+    void inherit_from_parents(const pdfObject& page_obj, pageEntry& entry, bool all_attributes = false) {
+        inherit_page_attributes(entry, page_obj);
+        const pdfObject* node = &page_obj;
+        for (int depth = 0; depth < max_page_tree_depth; ++depth) {
+            if (entry.resources->type != OBJ_NULL && entry.media_box->type != OBJ_NULL
+                && (!all_attributes || (entry.crop_box->type != OBJ_NULL && entry.rotate->type != OBJ_NULL))) return;
+            node = &node->get("/Parent");
+            if (!node->is_dict()) return;
+            // the nearest node that sets an attribute wins, so the parent only fills in what is still missing
+            pageEntry parent;
+            inherit_page_attributes(parent, *node);
+            if (entry.resources->type == OBJ_NULL) entry.resources = parent.resources;
+            if (entry.media_box->type == OBJ_NULL) entry.media_box = parent.media_box;
+            if (entry.crop_box->type == OBJ_NULL) entry.crop_box = parent.crop_box;
+            if (entry.rotate->type == OBJ_NULL) entry.rotate = parent.rotate;
+        }
     }
 
-    std::vector<std::size_t> parse_obj_ref_array(const std::string& ref_tag, const std::string& look_in) {
-        std::vector<std::size_t> objs;
+    /* walks the whole page tree once, depth first, & builds the flat page index with every page's inherited attributes resolved. nodes reached
+    twice (cycles in damaged files) are skipped. safe to call from several threads, only the first call does the walk */
+    void build_page_index(docCore& doc) {
+        objectsRoot& root = doc.objects_root;
+        std::call_once(root.pages_once, [&] {
+            // a sidecar index already lists the pages, only their inherited attributes are resolved
+            if (!root.indexed_page_refs.empty()) {
+                for (objectRef page_ref : root.indexed_page_refs) {
+                    pageEntry entry;
+                    entry.ref = page_ref;
+                    inherit_from_parents(get_object(doc, page_ref), entry, true);
+                    root.pages.push_back(entry);
+                }
+                root.pages_indexed.store(true, std::memory_order_release);
+                return;
+            }
 
-        // Regex to find the array
-        boost::regex array_regex(ref_tag + R"(\s*\[\s*((?:\d+\s+\d+\s+R\s*)+)\])");
-        boost::smatch array_match;
+            struct pendingNode {
+                const pdfObject* node;
+                pageEntry inherited;
+                int depth;
+            };
+            std::unordered_set<uint64_t> visited; // object keys
+            std::vector<pendingNode> stack;
+            if (root.pages_root.obj_num >= 0) stack.push_back({ &get_object(doc, root.pages_root), pageEntry{}, 0 });
+            visited.insert(object_key(root.pages_root));
+
+            while (!stack.empty()) {
+                pendingNode pending = stack.back();
+                stack.pop_back();
+                if (pending.depth < 0) { // a depth of -1 marks a page, its attributes are already resolved
+                    root.pages.push_back(pending.inherited);
+                    continue;
+                }
+                pageEntry entry = pending.inherited;
+                inherit_page_attributes(entry, *pending.node);
+
+                // kids are pushed in reverse, so that they are popped in page order
+                const pdfObject& kids = pending.node->get("/Kids");
+                for (auto kid_iter = kids.array.rbegin(); kid_iter != kids.array.rend(); ++kid_iter) {
+                    if (kid_iter->type != OBJ_REF || kid_iter->ref.obj_num < 0 || pending.depth >= max_page_tree_depth) continue;
+                    if (!visited.insert(object_key(kid_iter->ref)).second) continue;
+
+                    const pdfObject& kid = get_object(doc, kid_iter->ref);
+                    if (!kid.is_dict()) continue;
+                    if (is_page_node(kid)) {
+                        pageEntry page_entry = entry;
+                        page_entry.ref = kid_iter->ref;
+                        inherit_page_attributes(page_entry, kid);
+                        stack.push_back({ &kid, page_entry, -1 });
+                    }
+                    else stack.push_back({ &kid, entry, pending.depth + 1 });
+                }
+            }
+            root.pages_indexed.store(true, std::memory_order_release);
+        });
+    }
 
-        if (boost::regex_search(look_in, array_match, array_regex)) {
-            std::string array_content = array_match[1].str();
-            boost::regex ref_regex(R"((\d+)\s+(\d+)\s+R)");
-            boost::sregex_iterator iter(array_content.begin(), array_content.end(), ref_regex);
-            boost::sregex_iterator end;
-            while (iter != end) {
-                objs.push_back(doc_core.object_refs[std::stoi((*iter)[1])][std::stoi((*iter)[2])].object_offset);
-                ++iter;
+    /* finds page page_num without the page index, descending from the root & skipping whole subtrees using their /Count, so only the nodes on
+    the path to the page & their siblings are read. returns false if the tree doesn't lead to the page, e.g. because a /Count is missing or wrong */
+    bool find_page(docCore& doc, int page_num, pageEntry& entry) {
+        if (page_num < 0 || doc.objects_root.pages_root.obj_num < 0) return false;
+        const pdfObject* node = &get_object(doc, doc.objects_root.pages_root);
+        inherit_page_attributes(entry, *node);
+
+        for (int depth = 0; depth < max_page_tree_depth; ++depth) {
+            const pdfObject* next_node = nullptr;
+            for (const pdfObject& kid_ref : node->get("/Kids").array) {
+                if (kid_ref.type != OBJ_REF) continue;
+                const pdfObject& kid = get_object(doc, kid_ref.ref);
+                if (!kid.is_dict()) continue;
+                if (is_page_node(kid)) {
+                    if (page_num-- > 0) continue;
+                    entry.ref = kid_ref.ref;
+                    inherit_page_attributes(entry, kid);
+                    return true;
+                }
+                long long count = kid.get_int("/Count", -1);
+                if (count < 0) return false;
+                if (page_num < count) {
+                    next_node = &kid;
+                    break;
+                }
+                page_num -= static_cast<int>(count);
             }
+            if (!next_node) return false;
+            node = next_node;
+            inherit_page_attributes(entry, *node);
         }
-
-        return objs;
+        return false;
     }
 
-    // rewrite with more effcient approach later
-    std::map<std::string, std::size_t> parse_obj_ref_dict(const std::string& dict_tag, const std::string& look_in) {
-        std::map<std::string, std::size_t> obj_map;
-
-        // Construct the regex pattern
-        boost::regex dict_regex(dict_tag + R"(\s*<<\s*((?:/\w+\s+\d+\s+\d+\s*R\s*)+)>>)");
-
-        boost::sregex_iterator iter(look_in.begin(), look_in.end(), dict_regex);
-        boost::sregex_iterator end;
-
-        for (; iter != end; ++iter) {
-            std::string dict_content = (*iter)[1];
-
-            // Regex to find individual references within the dictionary content
-            boost::regex ref_regex(R"(/(\w+)\s+(\d+)\s+(\d+)\s*R\s*)");
-            boost::sregex_iterator ref_iter(dict_content.begin(), dict_content.end(), ref_regex);
-            boost::sregex_iterator ref_end;
-
-            for (; ref_iter != ref_end; ++ref_iter) {
-                obj_map.emplace((*ref_iter)[1], doc_core.object_refs[std::stoi((*ref_iter)[2])][std::stoi((*ref_iter)[3])].object_offset);
-            }
-            return obj_map;
+    /* finds a page of a linearised file without the page tree: the first page is /O & the others come from the page offset hint table. returns
+    false if the document isn't linearised or the object found isn't a page */
+    bool find_linearised_page(docCore& doc, int page_num, pageEntry& entry) {
+        linearisationInfo& lin = doc.linearisation;
+        if (!lin.linearised || page_num < 0 || page_num >= lin.page_count) return false;
+        objectRef ref{ lin.first_page_obj_num, 0 };
+        /* every object of the first page lies before /E, so a partly available document reads them all with one request rather than a growing
+        window per object. a failed read is left to the fetches of the objects themselves */
+        if (page_num == 0) doc.file.ensure(0, lin.first_page_end);
+        if (page_num > 0) {
+            load_page_hints(doc);
+            if (static_cast<std::size_t>(page_num) >= lin.page_hints.size()) return false;
+            ref.obj_num = lin.page_hints[page_num].first_obj_num;
         }
+        const pdfObject& page_obj = get_object(doc, ref);
+        if (!page_obj.is_dict() || page_obj.get_name("/Type") != "/Page") return false;
+        entry.ref = ref;
+        inherit_from_parents(page_obj, entry);
+        return true;
     }
 
-    std::size_t get_xref_table_position() {
-        return doc_core.ref_struct.startxref;
+    void init_objects_root(docCore& doc) {
+        const pdfObject& root = get_object(doc, doc.ref_struct.root_object_ref);
+        const pdfObject* pages_root = root.find("/Pages");
+        if (pages_root && pages_root->type == OBJ_REF) doc.objects_root.pages_root = pages_root->ref;
+        // the page count is taken from the tree's root, when that is missing the tree has to be walked to count the pages
+        long long page_count = get_object(doc, doc.objects_root.pages_root).get_int("/Count", -1);
+        if (page_count < 0) build_page_index(doc);
+        doc.objects_root.page_count = page_count < 0 ? static_cast<int>(doc.objects_root.pages.size()) : static_cast<int>(page_count);
     }
 
-    rect parse_rect(const std::string& rect_tag, const std::string& look_in) {
-        rect parsed_rect;
+    /* returns the offset held by the last startxref, which points at the newest xref section (a table or an xref stream), or npos if there is
+    none. incremental updates each append a section & a startxref. it is normally in the last kilobyte, the whole file is only searched when not */
+    std::size_t find_startxref(docCore& doc) {
+        std::size_t file_size = doc.doc_contents.size();
+        std::size_t tail_start = file_size > 1024 ? file_size - 1024 : 0;
+        std::string_view contents = fetch(doc, tail_start, file_size - tail_start);
+        std::size_t startxref_pos = contents.substr(tail_start).rfind("startxref");
+        if (startxref_pos != std::string_view::npos) startxref_pos += tail_start;
+        else startxref_pos = (contents = fetch(doc, 0, file_size)).rfind("startxref");
+        if (startxref_pos == std::string_view::npos) return std::string_view::npos;
+        std::size_t pos = startxref_pos + 9;
+        long long startxref = read_uint(contents, pos);
+        if (startxref < 0) return std::string_view::npos;
+        return static_cast<std::size_t>(startxref);
+    }
 
-        // Updated regex to handle both integers and decimal numbers
-        boost::regex rect_regex(rect_tag + R"(\s*\[\s*([-+]?[0-9]*\.?[0-9]+)\s*([-+]?[0-9]*\.?[0-9]+)\s*([-+]?[0-9]*\.?[0-9]+)\s*([-+]?[0-9]*\.?[0-9]+)\s*\])");
-        boost::smatch match;
+    // reads the cross-reference data & page list of the document doc has mapped, returns false if it is malformed
+    bool load_document(docCore& doc) {
+        /* check if PDF is in linearised form, & if so, parse it according to its linearised structure */
 
-        if (boost::regex_search(look_in, match, rect_regex)) {
-            parsed_rect.bottom_left.x = std::stod(match[1]);
-            parsed_rect.bottom_left.y = std::stod(match[2]);
-            parsed_rect.top_right.x = std::stod(match[3]);
-            parsed_rect.top_right.y = std::stod(match[4]);
+        // the linearisation dictionary has to be the first object in the file, within its first 1024 bytes
+        lexer header_lexer(fetch(doc, 0, 1024).substr(0, 1024));
+        for (token tok = header_lexer.next(); tok.type != TOKEN_END; tok = header_lexer.next()) {
+            if (!is_keyword(tok, "obj")) continue;
+            std::size_t obj_end = 0;
+            pdfObject first_obj = parse_fetched(doc, header_lexer.position(), [&](lexer& obj_lexer) {
+                pdfObject parsed = parse_object(obj_lexer, &doc);
+                obj_end = is_keyword(obj_lexer.next(), "endobj") ? obj_lexer.position() : 0;
+                return parsed;
+            });
+            if (first_obj.find("/Linearized") && obj_end != 0) {
+                if (load_linearised_document(doc, first_obj, obj_end)) return true;
+                // not usable as linearised, start again from the end of the file
+                doc.object_refs.clear();
+                doc.object_cache.clear();
+                doc.deferred_xref_pos = std::string_view::npos;
+            }
+            break;
         }
-        return parsed_rect;
-    }
 
-    
-    // for old-style text xref tables, use parse_xref_stream() for the newer xref streams introduced in PDF 1.5
-    void parse_xref_table(std::size_t xref_pos) {
-        std::istringstream iss(doc_core.doc_contents);
-        iss.seekg(xref_pos); // go to xref position
-        std::string line;
+        /* For normal PDF formats (comptible with version 1.5+)*/
 
-        std::getline(iss, line);  // skip xref symbol
+        std::size_t startxref = find_startxref(doc);
+        if (startxref == std::string_view::npos) return false;
+        doc.ref_struct.startxref = startxref;
 
-        int cur_obj_num = 0;
-      
-        while (std::getline(iss, line)) {
-            if (line == "trailer"  || line == "xref") break;
+        // /ObjStm are only inflated when first used
+        if (!parse_xref_chain(doc, doc.ref_struct.startxref)) return false; // the file being parsed is obviously malformed
+        init_objects_root(doc);
+        return true;
+    }
 
-            // Parse subsection header, this tells us the number of the first object in the xref & the amount of objects in the xref
-            int first_obj_num, obj_count;
-            std::istringstream header_stream(line);
-            header_stream >> first_obj_num >> obj_count;
-            cur_obj_num = first_obj_num;
 
+    /* sidecar index files. reopening a document normally redoes its xref parsing, /ObjStm header parsing & page tree walk, a sidecar index stores
+    their results (the packed xref, every /ObjStm's offset table & the page list) so a later open only maps the index & validates it. an index
+    belongs to one version of a file, keyed by its size, modification time & trailer /ID */
 
-            for (int i = 0; i < obj_count; ++i) {
-                std::getline(iss, line);
-                std::istringstream line_stream(line);
-                xrefEntry entry;
+    const char index_magic[8] = { 'P', 'D', 'F', 'I', 'D', 'X', '0', '1' };
 
-                std::cout << line << "\n";
+    struct indexKey {
+        uint64_t file_size = 0;
+        int64_t modified = 0; // the file's modification time, in the filesystem clock's ticks
+    };
 
-                line_stream >> entry.object_offset >> entry.gen_num >> entry.status;
+    bool get_index_key(const std::string& path, indexKey& key) {
+        std::error_code error;
+        key.file_size = std::filesystem::file_size(path, error);
+        if (error) return false;
+        auto modified = std::filesystem::last_write_time(path, error);
+        if (error) return false;
+        key.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+        return true;
+    }
 
-                if (entry.gen_num == 0) cur_obj_num = first_obj_num + i; // if the entry has a gen number of 0 we have a new obj ref, so ++ cur_obj_num
+    /* reads the /ID of the newest trailer, the xref stream's dictionary or the trailer after the table the last startxref points at, without
+    reading the xref itself */
+    bool read_newest_doc_id(docCore& doc, std::array<std::string, 2>& doc_id) {
+        std::size_t xref_pos = find_startxref(doc);
+        if (xref_pos >= doc.doc_contents.size()) return false;
+        std::string_view contents = fetch(doc, xref_pos, initial_fetch_window);
+        while (xref_pos < contents.size() && is_pdf_whitespace(contents[xref_pos])) ++xref_pos;
+
+        std::size_t trailer_pos = xref_pos;
+        if (contents.substr(xref_pos, 4) == "xref") {
+            trailer_pos = fetch_until(doc, xref_pos, "trailer").find("trailer", xref_pos);
+            if (trailer_pos == std::string_view::npos) return false;
+            trailer_pos += 7;
+        }
+        pdfObject trailer = parse_fetched(doc, trailer_pos, [&doc](lexer& lex) {
+            skip_object_header(lex);
+            return parse_object(lex, &doc);
+        });
+        read_doc_id(trailer, doc_id);
+        return trailer.is_dict();
+    }
 
-                doc_core.object_refs[cur_obj_num][entry.gen_num] = entry; // add entry to appropriate index
-            }
-            
+    /* writes the sidecar index for a freshly loaded document, to a temporary file that replaces index_path once complete so that readers on other
+    processes never see a partial index. everything the index holds is resolved first: a linearised file's main xref, every /ObjStm's offset table
+    (which inflates them) & the page list, so this costs more than the open it follows. failures are ignored, the index is only an optimisation */
+    void write_index(docCore& doc, const std::string& index_path, const indexKey& key) {
+        build_page_index(doc);
+        std::lock_guard<std::recursive_mutex> lock(doc.object_mutex);
+        if (doc.deferred_xref_pos != std::string_view::npos) load_deferred_xref(doc);
+
+        std::string out(index_magic, sizeof(index_magic));
+        append_u64(out, key.file_size);
+        append_u64(out, static_cast<uint64_t>(key.modified));
+        for (const std::string& id : doc.ref_struct.id) {
+            append_u64(out, id.size());
+            out += id;
+        }
+        for (objectRef ref : { doc.ref_struct.root_object_ref, doc.ref_struct.info_object_ref, doc.objects_root.pages_root }) {
+            append_u64(out, static_cast<uint64_t>(static_cast<int64_t>(ref.obj_num)));
+            append_u64(out, static_cast<uint64_t>(static_cast<int64_t>(ref.gen_num)));
         }
-        for (const auto& ref : doc_core.object_refs) {
-            std::cout << ref.first << " ";
-            for (const auto& nested_ref : ref.second) {
-                std::cout << nested_ref.first << " " << nested_ref.second.object_offset << "\n";
+        append_u64(out, doc.ref_struct.startxref);
+        doc.object_refs.write(out);
+
+        // the /ObjStm holding any compressed object
+        std::vector<int> obj_stm_nums;
+        xrefEntry entry;
+        for (std::size_t obj_num = 0; obj_num < doc.object_refs.size(); ++obj_num) {
+            if (doc.object_refs.find({ static_cast<int>(obj_num), 0 }, entry) && entry.status == 'c') obj_stm_nums.push_back(entry.obj_stm_num);
+        }
+        std::sort(obj_stm_nums.begin(), obj_stm_nums.end());
+        obj_stm_nums.erase(std::unique(obj_stm_nums.begin(), obj_stm_nums.end()), obj_stm_nums.end());
+        append_u64(out, obj_stm_nums.size());
+        for (int obj_stm_num : obj_stm_nums) {
+            const objectStream& obj_stream = load_obj_stream(doc, obj_stm_num);
+            append_u64(out, static_cast<uint64_t>(obj_stm_num));
+            append_u64(out, obj_stream.obj_nums.size());
+            for (std::size_t i = 0; i < obj_stream.obj_nums.size(); ++i) {
+                append_u64(out, static_cast<uint64_t>(obj_stream.obj_nums[i]));
+                append_u64(out, obj_stream.obj_offsets[i]);
             }
         }
-    }
 
-    void parse_doc_trailer(const std::string& trailer_content) {
-        boost::regex root_regex(R"(/Root\s+(\d+)\s+(\d+)\s+R)");
-        boost::smatch root_match;
-        if (boost::regex_search(trailer_content, root_match, root_regex)) {
-            doc_core.ref_struct.root_object_ref.obj_num = std::stoi(root_match[1]);
-            doc_core.ref_struct.root_object_ref.gen_num = std::stoi(root_match[2]);
+        append_u64(out, doc.objects_root.pages.size());
+        for (const pageEntry& page_entry : doc.objects_root.pages) {
+            append_u64(out, static_cast<uint64_t>(page_entry.ref.obj_num));
+            append_u64(out, static_cast<uint64_t>(page_entry.ref.gen_num));
         }
 
-        // Parse Info object number
-        boost::regex info_regex(R"(/Info\s+(\d+)\s+(\d+)\s+R)");
-        boost::smatch info_match;
-        if (boost::regex_search(trailer_content, info_match, info_regex)) {
-            doc_core.ref_struct.info_object_ref.obj_num = std::stoi(info_match[1]);
-            doc_core.ref_struct.info_object_ref.gen_num = std::stoi(info_match[2]);
+#ifdef PDF_PARSER_HAS_MMAP
+        // mkstemp creates a file no other process or thread can also be writing, so the rename only ever publishes a whole index
+        std::string temp_path = index_path + ".tmpXXXXXX";
+        int fd = mkstemp(temp_path.data());
+        if (fd < 0) return;
+        fchmod(fd, 0644); // mkstemp's files are private to the owner, the index is as readable as an ordinary file
+        std::size_t written = 0;
+        while (written < out.size()) {
+            ssize_t n = ::write(fd, out.data() + written, out.size() - written);
+            if (n <= 0) break;
+            written += static_cast<std::size_t>(n);
         }
-
-        // Parse ID
-        boost::regex id_regex(R"(/ID\s*\[\s*<([^>]+)>\s*<([^>]+)>\s*\])");
-        boost::smatch id_match;
-        if (boost::regex_search(trailer_content, id_match, id_regex)) {
-            doc_core.ref_struct.id = {id_match[1], id_match[2]};
+        if (::close(fd) != 0 || written < out.size()) {
+            std::remove(temp_path.c_str());
+            return;
         }
+#else
+        // without mkstemp the temp file is named by a random value per process & a counter, so no two writers share one
+        static const unsigned process_tag = std::random_device()();
+        static std::atomic<unsigned> temp_count{ 0 };
+        std::ostringstream temp_name;
+        temp_name << index_path << ".tmp" << std::hex << process_tag << '.' << temp_count.fetch_add(1, std::memory_order_relaxed);
+        std::string temp_path = temp_name.str();
+        {
+            std::ofstream index_file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!index_file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+                index_file.close();
+                std::remove(temp_path.c_str());
+                return;
+            }
+        }
+#endif
+        if (std::rename(temp_path.c_str(), index_path.c_str()) != 0) std::remove(temp_path.c_str());
     }
 
-    std::map<int, std::vector<deflatedObjRef>> get_deflated_obj_refs(const std::string& xref_stream) { // 
-        std::map<int, std::vector<deflatedObjRef>> obj_refs; // Keyed by object stream number
+    /* loads doc's xref, /ObjStm offset tables & page list from the sidecar index at index_path, in place of load_document(). returns false, with
+    doc untouched, if there is no index or it belongs to a different version of the file */
+    bool load_index(docCore& doc, const std::string& index_path, const indexKey& key) {
+        mappedFile index_file;
+        if (!index_file.open(index_path, LOAD_MAPPED)) return false;
+        std::string_view index_data = index_file.view();
+        if (index_data.size() < sizeof(index_magic) || index_data.compare(0, sizeof(index_magic), std::string_view(index_magic, sizeof(index_magic))) != 0) return false;
+        indexReader in(index_data.substr(sizeof(index_magic)));
+
+        uint64_t file_size = 0, modified = 0;
+        if (!in.read(file_size) || !in.read(modified) || file_size != key.file_size || static_cast<int64_t>(modified) != key.modified) return false;
+        std::array<std::string, 2> index_id;
+        for (std::string& id : index_id) {
+            std::size_t id_size = 0;
+            std::string_view id_bytes;
+            if (!in.read_count(1, id_size) || !in.read_bytes(id_size, id_bytes)) return false;
+            id = std::string(id_bytes);
+        }
+        // the size & modification time can match a rewritten file, the /ID of its newest trailer shouldn't
+        std::array<std::string, 2> doc_id;
+        if (!read_newest_doc_id(doc, doc_id) || doc_id != index_id) return false;
+
+        std::array<objectRef, 3> refs; // root, info & page tree root
+        for (objectRef& ref : refs) {
+            uint64_t obj_num = 0, gen_num = 0;
+            in.read(obj_num);
+            in.read(gen_num);
+            ref = { static_cast<int>(static_cast<int64_t>(obj_num)), static_cast<int>(static_cast<int64_t>(gen_num)) };
+        }
+        uint64_t startxref = 0;
+        in.read(startxref);
+        xrefIndex object_refs;
+        if (!object_refs.read(in)) return false;
+
+        std::map<int, objectStream> obj_streams;
+        std::size_t obj_stm_count = 0;
+        if (!in.read_count(16, obj_stm_count)) return false;
+        for (std::size_t i = 0; i < obj_stm_count; ++i) {
+            uint64_t obj_stm_num = 0;
+            std::size_t obj_count = 0;
+            if (!in.read(obj_stm_num) || !in.read_count(16, obj_count)) return false;
+            objectStream& obj_stream = obj_streams[static_cast<int>(obj_stm_num)];
+            obj_stream.obj_nums.resize(obj_count);
+            obj_stream.obj_offsets.resize(obj_count);
+            for (std::size_t j = 0; j < obj_count; ++j) {
+                uint64_t obj_num = 0, offset = 0;
+                in.read(obj_num);
+                in.read(offset);
+                obj_stream.obj_nums[j] = static_cast<int>(obj_num);
+                obj_stream.obj_offsets[j] = static_cast<std::size_t>(offset);
+            }
+        }
 
+        std::vector<objectRef> page_refs;
+        std::size_t page_count = 0;
+        if (!in.read_count(16, page_count)) return false;
+        page_refs.resize(page_count);
+        for (objectRef& page_ref : page_refs) {
+            uint64_t obj_num = 0, gen_num = 0;
+            in.read(obj_num);
+            in.read(gen_num);
+            page_ref = { static_cast<int>(obj_num), static_cast<int>(gen_num) };
+        }
+        if (!in.ok()) return false;
+
+        doc.ref_struct.id = std::move(index_id);
+        doc.ref_struct.root_object_ref = refs[0];
+        doc.ref_struct.info_object_ref = refs[1];
+        doc.ref_struct.startxref = static_cast<std::size_t>(startxref);
+        doc.object_refs = std::move(object_refs);
+        doc.indexed_obj_streams = std::move(obj_streams);
+        doc.objects_root.pages_root = refs[2];
+        doc.objects_root.page_count = static_cast<int>(page_refs.size());
+        doc.objects_root.indexed_page_refs = std::move(page_refs);
+        return true;
+    }
 
-        std::istringstream xref_str_stream(xref_stream);
-        std::string line;
-        std::streampos current_pos = 0;
+    // load_document() for documents which may come from a source, a read failing while the document is opened makes it unreadable
+    bool load_source_document(docCore& doc) {
+        try {
+            return load_document(doc);
+        }
+        catch (const std::runtime_error&) {
+            return false;
+        }
+    }
 
+    /* each document owns all of its state, so documents can be opened & parsed on different threads at once. the returned document stays alive as
+    long as the caller or any of its pages hold it. returns nullptr if the file can't be read or is malformed */
+    std::shared_ptr<document> open(std::string path, loadMode mode, const std::string& index_path) {
+        auto core = std::make_unique<docCore>();
+        if (mode == LOAD_ON_DEMAND) {
+            auto source = std::make_unique<fileSource>();
+            if (!source->open(path) || !core->file.open(std::move(source))) return nullptr;
+        }
+        else if (!core->file.open(path, mode)) return nullptr;
+        core->doc_contents = core->file.view();
+
+        indexKey key;
+        bool use_index = !index_path.empty() && get_index_key(path, key);
+        if (use_index && load_index(*core, index_path, key)) return std::make_shared<document>(std::move(core));
+        if (!load_source_document(*core)) return nullptr;
+        if (use_index) write_index(*core, index_path, key);
+        return std::make_shared<document>(std::move(core));
+    }
 
+    std::shared_ptr<document> open(std::unique_ptr<byteSource> source) {
+        auto core = std::make_unique<docCore>();
+        if (!core->file.open(std::move(source))) return nullptr;
+        core->doc_contents = core->file.view();
+        if (!load_source_document(*core)) return nullptr;
+        return std::make_shared<document>(std::move(core));
+    }
 
-        while (std::getline(xref_str_stream, line)) {
-            std::streampos start_pos = current_pos;
-            current_pos += line.size() + 1; // +1 for the newline character
+    std::shared_ptr<document> open_memory(const char* data, std::size_t size) {
+        auto core = std::make_unique<docCore>();
+        if (!core->file.open(data, size)) return nullptr;
+        core->doc_contents = core->file.view();
+        if (!load_document(*core)) return nullptr;
+        return std::make_shared<document>(std::move(core));
+    }
 
-            if (!line.empty() && line[0] == '2') { // only process lines beginning with '2'
-                std::istringstream line_stream(line);
-                std::string obj_num_str, index_str;
+    document::document(std::unique_ptr<docCore> core) : core(std::move(core)) {}
 
-                // Ignore the first part (type) and read the next two parts
-                line_stream.ignore(std::numeric_limits<std::streamsize>::max(), ' ');
-                line_stream >> obj_num_str >> index_str;
+    document::~document() {}
 
-                int obj_num = std::stoi(obj_num_str);
-                int index = std::stoi(index_str);
+    std::size_t document::get_bytes_read() const {
+        return core->file.get_bytes_read();
+    }
 
-                deflatedObjRef ref = {
-                    index,
-                    static_cast<std::size_t>(start_pos),
-                    static_cast<std::size_t>(current_pos)
-                };
+    int document::get_num_pages() const {
+        const objectsRoot& root = core->objects_root;
+        if (root.pages_indexed.load(std::memory_order_acquire)) return static_cast<int>(root.pages.size());
+        return root.page_count;
+    }
 
-                obj_refs[obj_num].push_back(ref);
+    /* uses the page index when it has been built. otherwise a linearised file finds the page through its hint tables & others descend the page
+    tree using /Count, falling back to building the index */
+    page document::get_page(int page_num) const {
+        objectsRoot& root = core->objects_root;
+        pageEntry entry;
+        if (!root.pages_indexed.load(std::memory_order_acquire)) {
+            // pages listed by a sidecar index only need their own object & its parents
+            if (!root.indexed_page_refs.empty() && page_num >= 0 && static_cast<std::size_t>(page_num) < root.indexed_page_refs.size()) {
+                entry.ref = root.indexed_page_refs[page_num];
+                inherit_from_parents(get_object(*core, entry.ref), entry, true);
+                return page(shared_from_this(), entry);
             }
+            if (find_linearised_page(*core, page_num, entry) || find_page(*core, page_num, entry)) return page(shared_from_this(), entry);
         }
-    return obj_refs;
+        build_page_index(*core);
+        if (page_num < 0 || static_cast<std::size_t>(page_num) >= root.pages.size()) throw std::out_of_range("page number out of range");
+        return page(shared_from_this(), root.pages[page_num]);
     }
-    
-    /* reinserts decompressed objects, the return is used in parse_xref_stream, where the array of size_t is the start & end of the entry associated with
-    an object & the string, what should replace the old entry, as the entry no longer represents a type-2 compressed object */
-    std::map<std::array<std::size_t, 2>, std::string> reinsert_inflated_objs(const std::string& obj_stream,
-            const std::vector<deflatedObjRef>& deflated_obj_refs) {
 
-        std::map<std::array<std::size_t, 2>, std::string> obj_entries;
-        
-        /* /ObjStm have a sequence of numbers at their beggining, these are key-value pairs where the key is the object number & the value,
-        its offset in the stream. map each object to its offset */
-        std::map<int, std::size_t> obj_map;
-        std::istringstream stream(obj_stream);
-        int key, offset;
-        std::streampos objs_start = 0; // holds the current position of the stream, used to determine the end of the number header
-        while (stream >> key >> offset) {
-            obj_map[key] = offset;
-            objs_start = stream.tellg(); // update objs_start to new offset
+    /* a worker's queue of page numbers for parse_all_pages(). the worker takes pages from the front, idle workers steal from the back, so the
+    pages each worker was given stay mostly in order & workers finishing cheap pages early take over from those still on expensive ones */
+    class workStealingQueue {
+    public:
+        void push(int page_num) {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(page_num);
         }
 
-        /* The offsets mapped with each object are relative to the beggining of actual object definition in the stream, not the stream's true beggining where
-        the key-value pairs are held, therefore remove the key-value pairs from the stream */
-        std::size_t pos = static_cast<std::size_t>(objs_start); // since streampos can't be used for string operations
-        while (std::isspace(obj_stream[pos])) ++pos; // remove trailing whitespace for exact operations
-        std::string objs = obj_stream.substr(static_cast<std::size_t>(pos));
-
-        std::size_t xref_start; // holds where the xrefStream used to begin
-
-
-        /* the xref stream object is no longer needed, remove it to clear space for reinsertion of the decompressed objs */
-        boost::regex xref_stm_regex(R"(\d+\s+\d+\s+obj\s*<<((?:(?!/Type).)*?/Type\s*/XRef.*?>>\s*stream[\s\S]*?endstream)\s*endobj)");
-        boost::smatch xref_stm_match;
-        if (boost::regex_search(doc_core.doc_contents, xref_stm_match, xref_stm_regex)) {
-            xref_start = xref_stm_match.position();
-            std::size_t xref_length = xref_stm_match.length();
-            doc_core.doc_contents.erase(xref_start, xref_length);
+        bool pop(int& page_num) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty()) return false;
+            page_num = tasks.front();
+            tasks.pop_front();
+            return true;
         }
 
-        /* Now, go through each entry. each object will have its contents isolated from the stream & be placed back into the main document contents
-        in its corresponding position */
-        std::vector<std::size_t> obj_offsets;
-        std::size_t insertion_offset = xref_start; // this is the position where the objects will be reinserted
-        for (auto iter = obj_map.begin(); iter != obj_map.end(); ++iter) {
-            auto next_iter = std::next(iter);
-            std::size_t next_obj_offset = (next_iter != obj_map.end()) ? next_iter->second : objs.size();
-            std::string obj_contents = objs.substr(iter->second, next_obj_offset - iter->second);
-            std::string obj_sig(std::to_string(iter->first) + " 0 obj"); // since compressed objs are missing the '<obj num> <gen num> obj' prefix
-            std::string obj_string = obj_sig + obj_contents + "\nendobj\n";
-            doc_core.doc_contents.insert(insertion_offset, obj_string);
-            obj_offsets.push_back(insertion_offset);
-            insertion_offset += obj_string.length();
+        bool steal(int& page_num) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty()) return false;
+            page_num = tasks.back();
+            tasks.pop_back();
+            return true;
         }
 
-        int cur_obj = 0;
-        for (const auto& obj_ref : deflated_obj_refs) {
-            std::ostringstream entry;
-            entry << std::setw(10) << std::setfill('0') << obj_offsets[cur_obj] << " 00000 n \n";
-            obj_entries.emplace(std::array{ obj_ref.line_start, obj_ref.line_end }, entry.str());
-            ++cur_obj;
-        }
+    private:
+        std::deque<int> tasks;
+        std::mutex mutex;
+    };
 
-        return obj_entries;
+    resourceCacheStats document::get_resource_cache_stats() const {
+        return { core->resources.hits.load(std::memory_order_relaxed), core->resources.misses.load(std::memory_order_relaxed) };
     }
 
+    std::vector<pageResult> document::parse_all_pages(int n_threads) const {
+        build_page_index(*core); // every page will be needed, so walk the tree once rather than descending it for each
+        int page_count = get_num_pages();
+        std::vector<pageResult> results(page_count);
+        if (page_count == 0) return results;
+        if (n_threads <= 0) n_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        n_threads = std::min(n_threads, page_count);
+
+        // each worker starts with a contiguous run of pages, no new pages are queued after this so a worker finding every queue empty is done
+        std::vector<workStealingQueue> queues(n_threads);
+        for (int i = 0; i < page_count; ++i) queues[static_cast<std::size_t>(i) * n_threads / page_count].push(i);
+
+        std::exception_ptr error; // the first exception thrown by a worker, rethrown once all workers are done
+        std::mutex error_mutex;
+        auto worker = [&](int id) {
+            int page_num;
+            while (true) {
+                bool found = queues[id].pop(page_num);
+                for (int i = 1; i < n_threads && !found; ++i) found = queues[(id + i) % n_threads].steal(page_num);
+                if (!found) return;
+
+                try {
+                    page pg = get_page(page_num);
+                    pageResult& result = results[page_num]; // each page's result is only written by the worker parsing it
+                    result.media_box = pg.get_media_box();
+                    pg.parse_contents(&result.text_objects, &result.images); // one pass over the content stream for both
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                }
+            }
+        };
 
-    std::vector<uint8_t> apply_png_up_predictor(const std::vector<uint8_t>& input, int columns) {
-        std::vector<uint8_t> output;
-        output.reserve(input.size());
+        std::vector<std::thread> threads;
+        for (int id = 1; id < n_threads; ++id) threads.emplace_back(worker, id);
+        worker(0); // the calling thread is the first worker
+        for (std::thread& thread : threads) thread.join();
+        if (error) std::rethrow_exception(error);
+        return results;
+    }
 
-        // First row: assume Prior(x) = 0
-        for (int i = 0; i < columns; ++i) {
-            output.push_back(input[i]);
-        }
+    /* content stream interpretation. a page's content stream is tokenised once & its operators executed in order by contentInterpreter, which
+    keeps the graphics state (including the q/Q stack, the CTM & colours) & the text matrices, & reports what the page draws to a contentHandler */
 
-        // Process subsequent rows
-        for (std::size_t i = columns; i < input.size(); ++i) {
-            std::size_t prior_index = i - columns;
-            uint8_t predicted_byte = (input[i] + output[prior_index]) & 0xFF; // mod 256
-            output.push_back(predicted_byte);
-        }
+    const transformationMatrix identity_matrix{ 1, 0, 0, 1, 0, 0 };
 
-        return output;
+    // m1 followed by m2, in the PDF's row vector convention
+    transformationMatrix multiply(const transformationMatrix& m1, const transformationMatrix& m2) {
+        return {
+            m1.scale_x * m2.scale_x + m1.shear_y * m2.shear_x,
+            m1.scale_x * m2.shear_y + m1.shear_y * m2.scale_y,
+            m1.shear_x * m2.scale_x + m1.scale_y * m2.shear_x,
+            m1.shear_x * m2.shear_y + m1.scale_y * m2.scale_y,
+            m1.translate_x * m2.scale_x + m1.translate_y * m2.shear_x + m2.translate_x,
+            m1.translate_x * m2.shear_y + m1.translate_y * m2.scale_y + m2.translate_y
+        };
     }
 
+    coordinates transform(const transformationMatrix& m, double x, double y) {
+        return { x * m.scale_x + y * m.shear_x + m.translate_x, x * m.shear_y + y * m.scale_y + m.translate_y };
+    }
 
-    // used in parse_xref_stream, decompresses & structures the xref
-    std::string inflate_xref_stream(const std::vector<uint8_t> stream, xrefStreamInfo stream_info) {
-        z_stream zs{};
-        int ret = inflateInit(&zs);
+    // the text state parameters, which are part of the graphics state & so are saved & restored by q/Q too
+    struct textState {
+        std::string font_key; // the font's name in the page's /Font resources, without the '/'
+        double font_size = 0;
+        double char_spacing = 0; // Tc
+        double word_spacing = 0; // Tw
+        double horizontal_scaling = 100; // Tz, in percent
+        double leading = 0; // TL
+        double rise = 0; // Ts
+        int render_mode = 0; // Tr
+    };
 
-        std::vector<uint8_t> inflated_stream;
-        const int chunk_size = 16384; // 16 KB chunk size
-        std::vector<uint8_t> buffer(chunk_size);
+    struct contentState {
+        graphicsState graphics{ identity_matrix, colour{ 0, 0, 0 }, colour{ 0, 0, 0 }, 1.0, 10.0 };
+        textState text;
+    };
 
-        zs.next_in = const_cast<Bytef*>(stream.data());
-        zs.avail_in = static_cast<uInt>(stream.size());
+    // a path construction operator's segment. the points are in user space, as the operators give them
+    struct pathSegment {
+        enum segmentType : int {
+            MOVE_TO, // m & the start of re
+            LINE_TO, // l & the sides of re
+            CURVE_TO, // c, v & y, as a cubic bezier with both control points
+            CLOSE // h & the end of re
+        };
+        segmentType type;
+        std::array<coordinates, 3> points; // the control points & end point for curves, only the first is used otherwise
+    };
 
-        while (ret != Z_STREAM_END) {
-            zs.next_out = reinterpret_cast<Bytef*>(buffer.data());
-            zs.avail_out = chunk_size;
+    enum pathPaint : int {
+        PAINT_STROKE, // S & s
+        PAINT_FILL, // f, F & f*
+        PAINT_FILL_STROKE, // B, B*, b & b*
+        PAINT_NONE // n, which only ends the path (e.g. after a clipping path)
+    };
 
-            ret = inflate(&zs, Z_NO_FLUSH);
-            if (ret == Z_STREAM_ERROR || ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
-                inflateEnd(&zs);
-                return {}; // Return an empty vector on error
-            }
+    // receives what the page draws, in content stream order. every callback does nothing by default
+    class contentHandler {
+    public:
+        virtual ~contentHandler() = default;
+        virtual void begin_text() {} // BT
+        virtual void end_text() {} // ET
+        /* a string shown by Tj, ' or ", or part of a TJ array, still in the font's encoding. text_matrix is the text space the string starts at,
+        space_before is set on the parts of a TJ array after the first, which it splits at word gaps */
+        virtual void show_text(std::string_view, const contentState&, const transformationMatrix& /* text_matrix */, bool /* space_before */) {}
+        // Do, name is the XObject's name in the page's resources without the '/'
+        virtual void invoke_x_object(std::string_view /* name */, const contentState&) {}
+        virtual void paint_path(const std::vector<pathSegment>&, pathPaint, bool /* even_odd */, const contentState&) {}
+    };
 
-            inflated_stream.insert(inflated_stream.end(), buffer.data(), buffer.data() + chunk_size - zs.avail_out);
-        }
+    // the operators the interpreter executes, everything else is skipped along with its operands
+    enum contentOp : int {
+        OP_UNKNOWN,
+        // graphics state
+        OP_SAVE, OP_RESTORE, OP_CONCAT_MATRIX, OP_LINE_WIDTH, OP_MITER_LIMIT,
+        // colour
+        OP_STROKE_GRAY, OP_FILL_GRAY, OP_STROKE_RGB, OP_FILL_RGB, OP_STROKE_CMYK, OP_FILL_CMYK,
+        OP_STROKE_COLOUR_SPACE, OP_FILL_COLOUR_SPACE, OP_STROKE_COLOUR, OP_FILL_COLOUR,
+        // text objects, state & positioning
+        OP_BEGIN_TEXT, OP_END_TEXT, OP_FONT, OP_CHAR_SPACING, OP_WORD_SPACING, OP_HORIZONTAL_SCALING, OP_LEADING, OP_RISE, OP_RENDER_MODE,
+        OP_TEXT_MATRIX, OP_MOVE_TEXT, OP_MOVE_TEXT_SET_LEADING, OP_NEXT_LINE,
+        // text showing
+        OP_SHOW_TEXT, OP_SHOW_TEXT_ARRAY, OP_NEXT_LINE_SHOW_TEXT, OP_SPACING_NEXT_LINE_SHOW_TEXT,
+        // XObjects & inline images
+        OP_X_OBJECT, OP_INLINE_IMAGE_DATA,
+        // path construction & painting
+        OP_MOVE_TO, OP_LINE_TO, OP_CURVE_TO, OP_CURVE_TO_V, OP_CURVE_TO_Y, OP_CLOSE_PATH, OP_RECTANGLE,
+        OP_STROKE, OP_CLOSE_STROKE, OP_FILL, OP_FILL_EVEN_ODD, OP_FILL_STROKE, OP_FILL_STROKE_EVEN_ODD, OP_CLOSE_FILL_STROKE,
+        OP_CLOSE_FILL_STROKE_EVEN_ODD, OP_END_PATH
+    };
 
-       inflateEnd(&zs);
+    // operators are at most 3 characters, which are packed into one integer so that looking one up is a single switch
+    constexpr uint32_t content_op_key(std::string_view name) {
+        uint32_t key = 0;
+        for (char c : name) key = key << 8 | static_cast<unsigned char>(c);
+        return key;
+    }
 
-        
-        switch (stream_info.predictor) {
-        case PNG_NONE:
-            break;
-        case PNG_UP:
-            inflated_stream = apply_png_up_predictor(inflated_stream, stream_info.columns);
-            break;
-        default:
-            // no predictor
-            break;
+    contentOp lookup_content_op(std::string_view name) {
+        if (name.empty() || name.size() > 3) return OP_UNKNOWN;
+        switch (content_op_key(name)) {
+        case content_op_key("q"): return OP_SAVE;
+        case content_op_key("Q"): return OP_RESTORE;
+        case content_op_key("cm"): return OP_CONCAT_MATRIX;
+        case content_op_key("w"): return OP_LINE_WIDTH;
+        case content_op_key("M"): return OP_MITER_LIMIT;
+        case content_op_key("G"): return OP_STROKE_GRAY;
+        case content_op_key("g"): return OP_FILL_GRAY;
+        case content_op_key("RG"): return OP_STROKE_RGB;
+        case content_op_key("rg"): return OP_FILL_RGB;
+        case content_op_key("K"): return OP_STROKE_CMYK;
+        case content_op_key("k"): return OP_FILL_CMYK;
+        case content_op_key("CS"): return OP_STROKE_COLOUR_SPACE;
+        case content_op_key("cs"): return OP_FILL_COLOUR_SPACE;
+        case content_op_key("SC"): return OP_STROKE_COLOUR;
+        case content_op_key("SCN"): return OP_STROKE_COLOUR;
+        case content_op_key("sc"): return OP_FILL_COLOUR;
+        case content_op_key("scn"): return OP_FILL_COLOUR;
+        case content_op_key("BT"): return OP_BEGIN_TEXT;
+        case content_op_key("ET"): return OP_END_TEXT;
+        case content_op_key("Tf"): return OP_FONT;
+        case content_op_key("Tc"): return OP_CHAR_SPACING;
+        case content_op_key("Tw"): return OP_WORD_SPACING;
+        case content_op_key("Tz"): return OP_HORIZONTAL_SCALING;
+        case content_op_key("TL"): return OP_LEADING;
+        case content_op_key("Ts"): return OP_RISE;
+        case content_op_key("Tr"): return OP_RENDER_MODE;
+        case content_op_key("Tm"): return OP_TEXT_MATRIX;
+        case content_op_key("Td"): return OP_MOVE_TEXT;
+        case content_op_key("TD"): return OP_MOVE_TEXT_SET_LEADING;
+        case content_op_key("T*"): return OP_NEXT_LINE;
+        case content_op_key("Tj"): return OP_SHOW_TEXT;
+        case content_op_key("TJ"): return OP_SHOW_TEXT_ARRAY;
+        case content_op_key("'"): return OP_NEXT_LINE_SHOW_TEXT;
+        case content_op_key("\""): return OP_SPACING_NEXT_LINE_SHOW_TEXT;
+        case content_op_key("Do"): return OP_X_OBJECT;
+        case content_op_key("ID"): return OP_INLINE_IMAGE_DATA;
+        case content_op_key("m"): return OP_MOVE_TO;
+        case content_op_key("l"): return OP_LINE_TO;
+        case content_op_key("c"): return OP_CURVE_TO;
+        case content_op_key("v"): return OP_CURVE_TO_V;
+        case content_op_key("y"): return OP_CURVE_TO_Y;
+        case content_op_key("h"): return OP_CLOSE_PATH;
+        case content_op_key("re"): return OP_RECTANGLE;
+        case content_op_key("S"): return OP_STROKE;
+        case content_op_key("s"): return OP_CLOSE_STROKE;
+        case content_op_key("f"): return OP_FILL;
+        case content_op_key("F"): return OP_FILL;
+        case content_op_key("f*"): return OP_FILL_EVEN_ODD;
+        case content_op_key("B"): return OP_FILL_STROKE;
+        case content_op_key("B*"): return OP_FILL_STROKE_EVEN_ODD;
+        case content_op_key("b"): return OP_CLOSE_FILL_STROKE;
+        case content_op_key("b*"): return OP_CLOSE_FILL_STROKE_EVEN_ODD;
+        case content_op_key("n"): return OP_END_PATH;
+        default: return OP_UNKNOWN;
         }
+    }
 
+    // colour components are 0-1 in content streams
+    int colour_component(double value) {
+        return static_cast<int>(std::clamp(value, 0.0, 1.0) * 255.0 + 0.5);
+    }
 
-        /* the decompressed stream is actually non-readable binary data that requires futher interpretation before becoming a readable xref */
-
-        int status_width = stream_info.width[0];
-        int offset_width = stream_info.width[1];
-        int gen_num_width = stream_info.width[2];
-
-        /* type refers to the obj's current type, 0 means it represents a free obj, 1 an in-use obj & 2 an obj still compressed in a /ObjStm
-        for entries where type = 0:
-         field_1 = obj num of next free obj
-         field_2 = gen_num
-        for entries where type = 1:
-         field_1 = obj's byte offset
-         field_2 = gen_num
-        for entries where type = 2:
-         field_1 = the obj number of the /ObjStm where the object is stored, gen_num is always assumed to be 0
-         field_2 = object's index within the /ObjStm
-        */
-
-        struct entryValues {
-            uint64_t type;
-            uint64_t field_1;
-            uint64_t field_2;
-        };
-
-        std::vector<entryValues> entries;
-        std::size_t entry_size = status_width + offset_width + gen_num_width;
+    colour gray_colour(double gray) {
+        int level = colour_component(gray);
+        return { level, level, level };
+    }
 
-        for (std::size_t i = 0; i < inflated_stream.size(); i += entry_size) {
-            entryValues entry;
-            std::size_t pos = i;
+    colour cmyk_colour(double c, double m, double y, double k) {
+        return { colour_component((1 - c) * (1 - k)), colour_component((1 - m) * (1 - k)), colour_component((1 - y) * (1 - k)) };
+    }
 
-            entry.type = 0;
-            for (int j = 0; j < status_width; ++j) {
-                entry.type = (entry.type << 8) | static_cast<unsigned char>(inflated_stream[pos++]);
+    /* reads a page's /Contents, a single stream or an array of them, as the one stream they make up. the parts are decoded as they are read,
+    read_size bytes at a time, so the memory used is the same however large the content streams inflate to */
+    class contentReader {
+    public:
+        static constexpr std::size_t read_size = 16384;
+
+        contentReader(docCore& doc, const std::vector<objectRef>& parts) : doc(doc), parts(parts) {}
+
+        // appends about the next read_size bytes of content to out, which has to be the same string every call. returns false at the end
+        bool read(std::string& out) {
+            std::size_t start = out.size();
+            while (true) {
+                if (!decoder) {
+                    if (next_part == parts.size()) return out.size() > start;
+                    // parts are only split between tokens, but not necessarily at whitespace
+                    if (next_part > 0) out += '\n';
+                    const pdfObject& stream = get_object(doc, parts[next_part++]);
+                    if (stream.type != OBJ_STREAM) continue;
+                    decoder = std::make_unique<streamDecoder>(stream, out);
+                }
+                if (decoder->read(read_size)) return true;
+                decoder.reset();
             }
+        }
 
-            entry.field_1 = 0;
-            for (int j = 0; j < offset_width; ++j) {
-                entry.field_1 = (entry.field_1 << 8) | static_cast<unsigned char>(inflated_stream[pos++]);
-            }
+    private:
+        docCore& doc;
+        const std::vector<objectRef>& parts;
+        std::size_t next_part = 0;
+        std::unique_ptr<streamDecoder> decoder; // the part being read
+    };
 
-            entry.field_2 = 0;
-            for (int j = 0; j < gen_num_width; ++j) {
-                entry.field_2 = (entry.field_2 << 8) | static_cast<unsigned char>(inflated_stream[pos++]);
-            }
+    /* executes a content stream's operators. operands are collected as tokens until the operator that uses them, which is looked up once &
+    dispatched on. the content is lexed from a window which is refilled from the reader as it is used up, keeping only the operands still
+    waiting for their operator, so parts of the content which were already executed aren't held on to */
+    class contentInterpreter {
+    public:
+        explicit contentInterpreter(contentHandler& handler) : handler(handler) {}
 
-            entries.push_back(entry);
+        void run(contentReader& content) {
+            start(content);
+            while (step()) {}
         }
 
-        std::ostringstream xref; // the reconstructed xref table
+        // starts interpreting content, whose operators are then executed one step() at a time
+        void start(contentReader& content) {
+            reader = &content;
+            window.clear();
+            more = reader->read(window);
+            lex = lexer(window, 0, false);
+        }
 
-        for (const entryValues& entry : entries) {
-            switch (entry.type) {
-            case 0: // Free object
-                xref << std::setw(10) << std::setfill('0') << entry.field_1 << " "
-                    << std::setw(5) << std::setfill('0') << entry.field_2 << " f \n";
-                break;
-            case 1: // Used object
-                xref << std::setw(10) << std::setfill('0') << entry.field_1 << " "
-                    << std::setw(5) << std::setfill('0') << entry.field_2 << " n \n";
-                break;
-            case 2: // compressed object for extraction
-                xref << entry.type << " " << std::setw(5) << std::setfill('0') << entry.field_1 << " "
-                    << std::setw(10) << std::setfill('0') << entry.field_2 << " \n";
-            default:
-                break;
+        // executes the next operator, returns false once the content has none left
+        bool step() {
+            while (true) {
+                std::size_t start = lex.position();
+                token tok = lex.next();
+                // a token running up to the end of the window may continue in the content still to be read
+                if (more && lex.position() >= window.size()) {
+                    // the operands waiting for their operator are lexed again from the refilled window
+                    std::size_t keep_from = operands.empty() ? start : operands.front().pos;
+                    operands.clear();
+                    refill(keep_from);
+                    continue;
+                }
+                if (tok.type == TOKEN_END) return false;
+                if (tok.type != TOKEN_KEYWORD) {
+                    operands.push_back(tok);
+                    continue;
+                }
+                contentOp op = lookup_content_op(tok.text);
+                if (op == OP_INLINE_IMAGE_DATA) skip_inline_image();
+                else execute(op);
+                operands.clear();
+                return true;
             }
         }
 
-        return xref.str();
-    }
-    
-
-    void reinsert_xref(const std::map<std::array<std::size_t, 2>, std::string>& inflated_entries, xrefStreamInfo stream_info, const std::string& xref_stream) {
-        std::string xref = xref_stream;
+    private:
+        // drops the window's bytes before keep_from & reads more content after the rest. the lexer restarts at the window's start
+        void refill(std::size_t keep_from) {
+            window.erase(0, keep_from);
+            more = reader->read(window);
+            lex = lexer(window, 0, false);
+        }
 
-        /* The /XRef object is no longer needed & will not be counted in the objects, its associated entry should therefore now be removed: */
+        double number(std::size_t index) const { return operands[index].real_value; }
 
-        int startxref = doc_core.ref_struct.startxref; // the logged startxref refers to the offset of the /XRef obj, which should be deleted from the final xref
-        // returns a stringstream containing the entry generated from the startxref value
-        auto get_xref_obj_entry = [](int value) {
-            return (std::ostringstream() << std::setw(10) << std::setfill('0') << value << " 00000 n").str();
-        }; 
-        // find & erase entry
-        std::string obj_entry = get_xref_obj_entry(startxref);
-        std::size_t pos = xref.find(obj_entry);
-        if (pos != std::string::npos) {
-            xref.erase(pos, obj_entry.size());
+        // true if the operator has at least count operands, the last count of which are numbers. missing operands make an operator a no-op
+        bool has_numbers(std::size_t count) const {
+            if (operands.size() < count) return false;
+            return std::all_of(operands.end() - count, operands.end(), [](const token& operand) { return is_number(operand); });
         }
 
-        /* Update xref with decompressed objs' entries */
+        // the operand count from the end, so extra operands before them are ignored
+        double last(std::size_t from_end) const { return number(operands.size() - from_end); }
 
-        for (auto iter = inflated_entries.begin(); iter != inflated_entries.end(); ++iter) {
-            xref.erase(iter->first[0], iter->first[1] - iter->first[0]);
-            xref.insert(iter->first[0], iter->second);
+        void move_text(double tx, double ty) {
+            line_matrix = multiply({ 1, 0, 0, 1, tx, ty }, line_matrix);
+            text_matrix = line_matrix;
         }
 
-        /* All xrefs start with the 'xref' symbol & the subsection header containing the no. of the first object represented & teh amount represented, so update
-        xref to include this: */
-        std::string xref_header("\nxref\n" + std::to_string(stream_info.index[0]) + " " + std::to_string(stream_info.index[1]) + "\n");
-        xref.insert(0, xref_header);
+        // the last operand, if it is a string
+        const token* string_operand() const {
+            if (operands.empty() || (operands.back().type != TOKEN_STRING && operands.back().type != TOKEN_HEX_STRING)) return nullptr;
+            return &operands.back();
+        }
 
-        /* Now, reconstruct the trailer: */
+        // appends a string operand's bytes to shown, decoding its escapes or hex digits
+        static void append_string(const token& str, std::string& out) {
+            if (str.type == TOKEN_HEX_STRING) decode_hex_string(str.text, out);
+            else decode_literal_string(str.text, out);
+        }
 
-        std::string root_obj_ref(" " + std::to_string(doc_core.ref_struct.root_object_ref.obj_num) + " " +
-                                 std::to_string(doc_core.ref_struct.root_object_ref.gen_num) + " R");
-        std::string info_obj_ref(" " + std::to_string(doc_core.ref_struct.info_object_ref.obj_num) + " " +
-                                 std::to_string(doc_core.ref_struct.info_object_ref.gen_num) + " R");
-        std::string id("[<" + doc_core.ref_struct.id[0] + "><" + doc_core.ref_struct.id[1] + ">]");
-        std::string trailer("trailer\n<</Root" + root_obj_ref + "/Info" + info_obj_ref + "/ID" + id + ">>");
+        // Tj, ' & ". the text matrix isn't advanced past the string, as that needs the font's glyph widths
+        void show_text() {
+            const token* str = string_operand();
+            if (!str) return;
+            if (str->type == TOKEN_STRING && !needs_decoding(str->text)) {
+                handler.show_text(str->text, state, text_matrix, false); // used in place
+                return;
+            }
+            shown.clear();
+            append_string(*str, shown);
+            handler.show_text(shown, state, text_matrix, false);
+        }
 
-        /* proceed with reinsertion of xref & trailer: */
+        /* TJ, an array of strings & numbers. the numbers move the next string back by thousandths of an em, which isn't tracked without glyph
+        widths, so the strings are shown together. a gap of more than word_gap (a negative number moves it forward) is taken to be a space between
+        words, as kerning is much tighter, & splits the strings into runs there */
+        void show_text_array() {
+            static constexpr double word_gap = 200;
+            auto array_begin = std::find_if(operands.rbegin(), operands.rend(), [](const token& operand) { return operand.type == TOKEN_ARRAY_BEGIN; });
+            if (array_begin == operands.rend()) return;
+            shown.clear();
+            word_breaks.clear();
+            double adjustment = 0; // since the last string
+            for (auto element = array_begin.base(); element != operands.end(); ++element) {
+                if (is_number(*element)) {
+                    adjustment += element->real_value;
+                    continue;
+                }
+                if (element->type != TOKEN_STRING && element->type != TOKEN_HEX_STRING) continue;
+                if (adjustment < -word_gap && shown.size() > (word_breaks.empty() ? 0 : word_breaks.back())) word_breaks.push_back(shown.size());
+                adjustment = 0;
+                append_string(*element, shown);
+            }
+            // every run is shown once the whole array is decoded, so they all stay valid until the next operator
+            std::string_view all_shown = shown;
+            std::size_t run_start = 0;
+            for (std::size_t run_end : word_breaks) {
+                handler.show_text(all_shown.substr(run_start, run_end - run_start), state, text_matrix, run_start > 0);
+                run_start = run_end;
+            }
+            handler.show_text(all_shown.substr(run_start), state, text_matrix, run_start > 0);
+        }
 
-        std::size_t eof_pos = doc_core.doc_contents.rfind(R"(%%EOF)") - 1;
-        std::size_t xref_pos = doc_core.doc_contents.rfind("endobj", eof_pos) + 6; 
+        // sets a colour from the operands of sc/scn & SC/SCN, by their count as the colour space isn't tracked beyond that
+        void set_colour(colour& target) {
+            if (has_numbers(4)) target = cmyk_colour(last(4), last(3), last(2), last(1));
+            else if (has_numbers(3)) target = { colour_component(last(3)), colour_component(last(2)), colour_component(last(1)) };
+            else if (has_numbers(1)) target = gray_colour(last(1));
+        }
 
-        doc_core.doc_contents.erase(xref_pos, eof_pos - xref_pos);
-        doc_core.doc_contents.insert(xref_pos, xref);
-        std::size_t trailer_pos = xref_pos + xref.size();
-        doc_core.doc_contents.insert(trailer_pos, trailer);
-        doc_core.doc_contents.insert(trailer_pos + trailer.size(), std::string("\nstartxref\n" + std::to_string(xref_pos) + "\n"));
-        // update startxref (+1 because the xref string contains a \n before the actual xref symbol, which is what the value of startxref should be)
-        doc_core.ref_struct.startxref = xref_pos + 1;
-    }
-    
-    // xref streams are a compressed & compacted form of the old-style xref tables introduced in 1.5, they also allow for object compression
-    void parse_xref_stream(const std::string& obj_content) {
-        boost::regex root_regex(R"(/Root\s+(\d+)\s+(\d+)\s+R)");
-        boost::smatch root_match;
-        if (boost::regex_search(obj_content, root_match, root_regex)) {
-            doc_core.ref_struct.root_object_ref.obj_num = std::stoi(root_match[1]);
-            doc_core.ref_struct.root_object_ref.gen_num = std::stoi(root_match[2]);
+        void add_segment(pathSegment::segmentType type, coordinates p1 = {}, coordinates p2 = {}, coordinates p3 = {}) {
+            path.push_back({ type, { p1, p2, p3 } });
         }
 
-        // Parse Info object number
-        boost::regex info_regex(R"(/Info\s+(\d+)\s+(\d+)\s+R)");
-        boost::smatch info_match;
-        if (boost::regex_search(obj_content, info_match, info_regex)) {
-            doc_core.ref_struct.info_object_ref.obj_num = std::stoi(info_match[1]);
-            doc_core.ref_struct.info_object_ref.gen_num = std::stoi(info_match[2]);
+        void paint(pathPaint paint_op, bool close, bool even_odd) {
+            if (close) add_segment(pathSegment::CLOSE);
+            if (!path.empty()) handler.paint_path(path, paint_op, even_odd, state);
+            path.clear();
         }
 
-        boost::regex id_regex(R"(/ID\s*\[\s*<([^>]+)>\s*<([^>]+)>\s*\])");
-        boost::smatch id_match;
-        if (boost::regex_search(obj_content, id_match, id_regex)) {
-            doc_core.ref_struct.id = {id_match[1], id_match[2]};
+        /* inline image data follows 'ID' & a single whitespace byte & runs until 'EI'. it is binary so it can't be tokenised, instead the first
+        'EI' between whitespace (or at the end) is taken as its end. the window is refilled as the data is skipped */
+        void skip_inline_image() {
+            std::size_t pos = lex.position() + 1;
+            while (true) {
+                std::size_t candidate = window.find("EI", pos);
+                bool at_end = candidate != std::string::npos && candidate + 2 == window.size();
+                if (candidate == std::string::npos || (at_end && more)) {
+                    if (!more) break;
+                    // keep the byte before a possible 'EI' split over the refill
+                    std::size_t keep_from = std::max(pos, candidate == std::string::npos ? window.size() - 1 : candidate) - 1;
+                    refill(keep_from);
+                    pos = 1;
+                    continue;
+                }
+                bool starts_token = is_pdf_whitespace(window[candidate - 1]);
+                bool ends_token = at_end || is_pdf_whitespace(window[candidate + 2]) || is_pdf_delimiter(window[candidate + 2]);
+                if (starts_token && ends_token) {
+                    lex.seek(candidate + 2);
+                    return;
+                }
+                pos = candidate + 1;
+            }
+            lex.seek(window.size());
         }
 
-        xrefStreamInfo stream_info;
+        void execute(contentOp op) {
+            graphicsState& graphics = state.graphics;
+            textState& text = state.text;
+            switch (op) {
+            case OP_SAVE:
+                saved_states.push_back(state);
+                break;
+            case OP_RESTORE:
+                // unbalanced Q in damaged streams are ignored
+                if (!saved_states.empty()) {
+                    state = std::move(saved_states.back());
+                    saved_states.pop_back();
+                }
+                break;
+            case OP_CONCAT_MATRIX:
+                if (has_numbers(6)) graphics.ctm = multiply({ last(6), last(5), last(4), last(3), last(2), last(1) }, graphics.ctm);
+                break;
+            case OP_LINE_WIDTH:
+                if (has_numbers(1)) graphics.line_width = last(1);
+                break;
+            case OP_MITER_LIMIT:
+                if (has_numbers(1)) graphics.miter_limit = last(1);
+                break;
+
+            case OP_STROKE_GRAY:
+                if (has_numbers(1)) graphics.stroke_colour = gray_colour(last(1));
+                break;
+            case OP_FILL_GRAY:
+                if (has_numbers(1)) graphics.fill_colour = gray_colour(last(1));
+                break;
+            case OP_STROKE_RGB:
+                if (has_numbers(3)) graphics.stroke_colour = { colour_component(last(3)), colour_component(last(2)), colour_component(last(1)) };
+                break;
+            case OP_FILL_RGB:
+                if (has_numbers(3)) graphics.fill_colour = { colour_component(last(3)), colour_component(last(2)), colour_component(last(1)) };
+                break;
+            case OP_STROKE_CMYK:
+                if (has_numbers(4)) graphics.stroke_colour = cmyk_colour(last(4), last(3), last(2), last(1));
+                break;
+            case OP_FILL_CMYK:
+                if (has_numbers(4)) graphics.fill_colour = cmyk_colour(last(4), last(3), last(2), last(1));
+                break;
+            case OP_STROKE_COLOUR_SPACE: // setting a colour space resets the colour to its initial value, black for the common spaces
+                graphics.stroke_colour = { 0, 0, 0 };
+                break;
+            case OP_FILL_COLOUR_SPACE:
+                graphics.fill_colour = { 0, 0, 0 };
+                break;
+            case OP_STROKE_COLOUR:
+                set_colour(graphics.stroke_colour);
+                break;
+            case OP_FILL_COLOUR:
+                set_colour(graphics.fill_colour);
+                break;
 
-        boost::regex decode_params_regex(R"(/DecodeParams<</Columns\s+(\d+)/Predictor\s+(\d+)>>)");
-        boost::smatch decode_params_match;
-        if (boost::regex_search(obj_content, decode_params_match, decode_params_regex)) {
-            int columns = std::stoi(decode_params_match[1].str());
-            stream_info.columns = columns;
-            int predictor = std::stoi(decode_params_match[2].str());
-            switch (predictor) {
-            case 10:
+            case OP_BEGIN_TEXT:
+                text_matrix = line_matrix = identity_matrix;
+                handler.begin_text();
+                break;
+            case OP_END_TEXT:
+                handler.end_text();
                 break;
-            case 11:
+            case OP_FONT:
+                if (has_numbers(1) && operands.size() >= 2 && operands[operands.size() - 2].type == TOKEN_NAME) {
+                    text.font_key = std::string(operands[operands.size() - 2].text.substr(1));
+                    text.font_size = last(1);
+                }
                 break;
-            case 12:
-                stream_info.predictor = PNG_UP;
+            case OP_CHAR_SPACING:
+                if (has_numbers(1)) text.char_spacing = last(1);
                 break;
-            case 13:
+            case OP_WORD_SPACING:
+                if (has_numbers(1)) text.word_spacing = last(1);
                 break;
-            case 14:
+            case OP_HORIZONTAL_SCALING:
+                if (has_numbers(1)) text.horizontal_scaling = last(1);
                 break;
-            case 15:
+            case OP_LEADING:
+                if (has_numbers(1)) text.leading = last(1);
                 break;
-            default:
+            case OP_RISE:
+                if (has_numbers(1)) text.rise = last(1);
+                break;
+            case OP_RENDER_MODE:
+                if (has_numbers(1)) text.render_mode = static_cast<int>(last(1));
+                break;
+            case OP_TEXT_MATRIX:
+                if (has_numbers(6)) text_matrix = line_matrix = { last(6), last(5), last(4), last(3), last(2), last(1) };
+                break;
+            case OP_MOVE_TEXT:
+                if (has_numbers(2)) move_text(last(2), last(1));
+                break;
+            case OP_MOVE_TEXT_SET_LEADING:
+                if (has_numbers(2)) {
+                    text.leading = -last(1);
+                    move_text(last(2), last(1));
+                }
+                break;
+            case OP_NEXT_LINE:
+                move_text(0, -text.leading);
+                break;
+
+            case OP_SHOW_TEXT:
+                show_text();
+                break;
+            case OP_SHOW_TEXT_ARRAY:
+                show_text_array();
+                break;
+            case OP_NEXT_LINE_SHOW_TEXT:
+                move_text(0, -text.leading);
+                show_text();
+                break;
+            case OP_SPACING_NEXT_LINE_SHOW_TEXT: // aw ac string "
+                if (string_operand() && operands.size() >= 3) {
+                    const token& word_spacing = operands[operands.size() - 3];
+                    const token& char_spacing = operands[operands.size() - 2];
+                    if (is_number(word_spacing)) text.word_spacing = word_spacing.real_value;
+                    if (is_number(char_spacing)) text.char_spacing = char_spacing.real_value;
+                }
+                move_text(0, -text.leading);
+                show_text();
+                break;
+
+            case OP_X_OBJECT:
+                if (!operands.empty() && operands.back().type == TOKEN_NAME) handler.invoke_x_object(operands.back().text.substr(1), state);
+                break;
+
+            case OP_MOVE_TO:
+                if (has_numbers(2)) add_segment(pathSegment::MOVE_TO, { last(2), last(1) });
+                break;
+            case OP_LINE_TO:
+                if (has_numbers(2)) add_segment(pathSegment::LINE_TO, { last(2), last(1) });
+                break;
+            case OP_CURVE_TO:
+                if (has_numbers(6)) add_segment(pathSegment::CURVE_TO, { last(6), last(5) }, { last(4), last(3) }, { last(2), last(1) });
+                break;
+            case OP_CURVE_TO_V: // the first control point is the current point
+                if (has_numbers(4) && !path.empty()) {
+                    coordinates current = path.back().type == pathSegment::CURVE_TO ? path.back().points[2] : path.back().points[0];
+                    add_segment(pathSegment::CURVE_TO, current, { last(4), last(3) }, { last(2), last(1) });
+                }
+                break;
+            case OP_CURVE_TO_Y: // the second control point is the end point
+                if (has_numbers(4)) add_segment(pathSegment::CURVE_TO, { last(4), last(3) }, { last(2), last(1) }, { last(2), last(1) });
+                break;
+            case OP_CLOSE_PATH:
+                add_segment(pathSegment::CLOSE);
+                break;
+            case OP_RECTANGLE:
+                if (has_numbers(4)) {
+                    double x = last(4), y = last(3), width = last(2), height = last(1);
+                    add_segment(pathSegment::MOVE_TO, { x, y });
+                    add_segment(pathSegment::LINE_TO, { x + width, y });
+                    add_segment(pathSegment::LINE_TO, { x + width, y + height });
+                    add_segment(pathSegment::LINE_TO, { x, y + height });
+                    add_segment(pathSegment::CLOSE);
+                }
+                break;
+            case OP_STROKE: paint(PAINT_STROKE, false, false); break;
+            case OP_CLOSE_STROKE: paint(PAINT_STROKE, true, false); break;
+            case OP_FILL: paint(PAINT_FILL, false, false); break;
+            case OP_FILL_EVEN_ODD: paint(PAINT_FILL, false, true); break;
+            case OP_FILL_STROKE: paint(PAINT_FILL_STROKE, false, false); break;
+            case OP_FILL_STROKE_EVEN_ODD: paint(PAINT_FILL_STROKE, false, true); break;
+            case OP_CLOSE_FILL_STROKE: paint(PAINT_FILL_STROKE, true, false); break;
+            case OP_CLOSE_FILL_STROKE_EVEN_ODD: paint(PAINT_FILL_STROKE, true, true); break;
+            case OP_END_PATH: paint(PAINT_NONE, false, false); break;
+
+            default: // operators which don't affect what is extracted (e.g. line caps, dashes, clipping, marked content)
                 break;
             }
         }
 
-        boost::regex width_regex(R"(/W\s*\[\s*(\d+)\s*(\d+)\s*(\d+)\s*\])");
-        boost::smatch width_match;
-        if (boost::regex_search(obj_content, width_match, width_regex)) {
-            stream_info.width = { std::stoi(width_match[1]), std::stoi(width_match[2]), std::stoi(width_match[3]) };
+        contentHandler& handler;
+        contentReader* reader = nullptr;
+        std::string window; // the content being lexed, from the first operand still needed
+        bool more = false; // whether the reader has more content after the window
+        lexer lex{ std::string_view(), 0, false };
+        contentState state;
+        std::vector<contentState> saved_states; // the q/Q stack
+        transformationMatrix text_matrix = identity_matrix; // Tm
+        transformationMatrix line_matrix = identity_matrix; // the start of the current line
+        std::vector<token> operands;
+        std::string shown; // decoded text passed to show_text(), reused between operators
+        std::vector<std::size_t> word_breaks; // where a TJ array's runs end in shown, but for the last
+        std::vector<pathSegment> path; // the path being constructed, painted & cleared by the painting operators
+    };
+
+    /* passes a page's text runs to a textVisitor & collects its images, for page::visit_contents(). either may be null, e.g. text extraction
+    doesn't decode any images */
+    class pageContentCollector : public contentHandler {
+    public:
+        pageContentCollector(page& pg, textVisitor* text, std::vector<imageObject>* images) : pg(pg), text(text), images(images) {}
+
+        void begin_text() override {
+            if (text) text->begin_text_object();
         }
-        boost::regex index_regex(R"(/Index\s*\[\s*(\d+)\s*(\d+)\s*\])");
-        boost::smatch index_match;
-        if (boost::regex_search(obj_content, index_match, index_regex)) {
-            stream_info.index = { std::stoi(index_match[1]), std::stoi(index_match[2]) };
+
+        void end_text() override {
+            if (text) text->end_text_object();
         }
-        
-        boost::regex stream_regex(R"(stream\s*\n((?:(?!endstream)[\s\S])*)\s*endstream)");
-        boost::smatch stream_match;
-        if (boost::regex_search(obj_content, stream_match, stream_regex)) {
 
-            std::string xref_stream = inflate_xref_stream(std::vector<uint8_t>(stream_match[1].begin(), stream_match[1].end()), stream_info);
-            std::cout << xref_stream;
-            std::map<int, std::vector<deflatedObjRef>> deflated_obj_refs = get_deflated_obj_refs(xref_stream);
-            for (const auto& ref : deflated_obj_refs) {
-                std::string obj_stream = inflate_obj_stream(ref.first);
-                std::map<std::array<std::size_t, 2>, std::string> inflated_obj_entries = reinsert_inflated_objs(obj_stream, ref.second);        
-                reinsert_xref(inflated_obj_entries, stream_info, xref_stream);
+        void show_text(std::string_view shown, const contentState& state, const transformationMatrix& text_matrix, bool space_before) override {
+            if (!text || state.text.font_key.empty()) return;
+            // runs mostly share the font before them, so the font is only looked up when it changes
+            if (!font || state.text.font_key != font_key) {
+                font = pg.load_font(state.text.font_key).get(); // kept alive by the document's font cache
+                font_key = state.text.font_key;
             }
+            textRun run;
+            run.text = shown;
+            run.font_key = font_key;
+            run.font = font;
+            run.font_size = state.text.font_size;
+            run.position = transform(state.graphics.ctm, text_matrix.translate_x, text_matrix.translate_y);
+            run.space_before = space_before;
+            text->visit(run);
         }
-    }
 
-    // TO BE COMPLETED
-    void prepare_linearised_pdf(const std::string& linearisation_header) {
-        boost::regex hint_tbl_ref_regex(R"(/H\s*\[\s*(\d+)\s*(\d+)\s*\])");
-        boost::smatch hint_tbl_ref_match;
-        boost::regex_search(linearisation_header, hint_tbl_ref_match, hint_tbl_ref_regex);
-        // extract hint table
-        std::size_t hint_tbl_offset = std::stoull(hint_tbl_ref_match[1]);
-        std::size_t hint_tbl_size = std::stoull(hint_tbl_ref_match[2]);
-        std::string hint_tbl_obj = doc_core.doc_contents.substr(hint_tbl_offset, hint_tbl_size);
-        std::cout << hint_tbl_obj;
-        std::cout << "\n\n" << doc_core.doc_contents[512] << doc_core.doc_contents[513] << doc_core.doc_contents[514];
-    }
+        void invoke_x_object(std::string_view name, const contentState& state) override {
+            if (images) pg.add_image(std::string(name), state.graphics, *images);
+        }
 
-    void init_objects_root() {
-        std::size_t root_object = 0;
-        root_object = doc_core.object_refs[doc_core.ref_struct.root_object_ref.obj_num][doc_core.ref_struct.root_object_ref.gen_num].object_offset;
-        doc_core.objects_root.object_contents = isolate_object_contents(doc_core.doc_contents, root_object); 
-        std::size_t pages_obj = parse_obj_ref("/Pages", doc_core.objects_root.object_contents);
-        doc_core.objects_root.pages = parse_obj_ref_array("/Kids", isolate_object_contents(doc_core.doc_contents, pages_obj));
-        doc_core.objects_root.page_count = doc_core.objects_root.pages.size();
-    }
+    private:
+        page& pg;
+        textVisitor* text;
+        std::vector<imageObject>* images;
+        std::string font_key;
+        const fontObject* font = nullptr;
+    };
 
-// TODO: support linearisation
+    /* groups text runs into the textObjects returned by page::parse_text_objects(), one per BT/ET pair. text_coordinates is where the object's
+    first run starts & a new text block starts whenever the font or its size changes */
+    class textObjectBuilder : public textVisitor {
+    public:
+        textObjectBuilder(page& pg, std::vector<textObject>& text_objs) : pg(pg), text_objs(text_objs) {}
 
-    int open(std::string path) {
-        std::ifstream file(path, std::ios::binary);
-        if (!file) return 1;
+        void begin_text_object() override {
+            obj = textObject{};
+            in_text_obj = true;
+        }
+
+        void end_text_object() override {
+            if (!in_text_obj) return;
+            text_objs.push_back(std::move(obj));
+            in_text_obj = false;
+        }
 
-        std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        void visit(const textRun& run) override {
+            if (!in_text_obj) return;
+            if (obj.text_blocks.empty()) obj.text_coordinates = run.position;
+            int text_size = static_cast<int>(run.font_size);
+            if (obj.text_blocks.empty() || run.font != block_font.get() || obj.text_blocks.back().text_size != text_size) {
+                // the font is kept between text objects, which mostly use the same one
+                if (run.font != block_font.get()) block_font = pg.load_font(std::string(run.font_key));
+                textData text_block;
+                text_block.font = block_font;
+                text_block.text_size = text_size;
+                obj.text_blocks.push_back(std::move(text_block));
+            }
+            if (run.space_before) obj.text_blocks.back().text += ' ';
+            if (run.font) run.font->decode(run.text, obj.text_blocks.back().text);
+            else obj.text_blocks.back().text += run.text;
+        }
 
-        file.close();
-        doc_core.doc_contents.clear();
-        doc_core.doc_contents.assign(buffer.begin(), buffer.end());
+    private:
+        page& pg;
+        std::vector<textObject>& text_objs;
+        textObject obj;
+        bool in_text_obj = false;
+        std::shared_ptr<fontObject> block_font; // the font of the last block started
+    };
 
-        /* check if PDF is in linearised form, & if so, parse it according to its linearised structure */
+    // the text runs are copied into blocks of at least this size
+    constexpr std::size_t text_arena_block_size = 65536;
 
-        boost::regex linearisation_header_regex(R"(\d+\s+\d+\s+obj\s*<<(.*?/Linearized.*?)>>\s*endobj)");
-        boost::smatch linearisation_header_match;
-        if (boost::regex_search(doc_core.doc_contents, linearisation_header_match, linearisation_header_regex)) {
-            std::cout << linearisation_header_match[1].str();
-            prepare_linearised_pdf(linearisation_header_match[1]);
-            return 0;
+    std::string_view textRunCollector::store(std::string_view text) {
+        if (blocks.empty() || block_size - block_used < text.size()) {
+            block_size = std::max(text_arena_block_size, text.size());
+            blocks.push_back(std::make_unique<char[]>(block_size));
+            block_used = 0;
         }
+        char* copy = blocks.back().get() + block_used;
+        std::copy(text.begin(), text.end(), copy);
+        block_used += text.size();
+        return std::string_view(copy, text.size());
+    }
 
-        /* For normal PDF formats (comptible with version 1.5+)*/
+    void textRunCollector::visit(const textRun& run) {
+        textRun stored = run;
+        stored.text = store(run.text);
+        stored.font_key = store(run.font_key);
+        runs.push_back(stored);
+    }
 
-        // Parse startxref
-        boost::regex startxref_regex(R"(startxref\s*(\d+))");
-        boost::smatch startxref_match;
-        if (boost::regex_search(doc_core.doc_contents, startxref_match, startxref_regex)) {
-            doc_core.ref_struct.startxref = std::stoull(startxref_match[1]);
-        }
-        
-        // parse PDF's primary trailer ( if it has one )
-        boost::regex trailer_regex(R"(trailer\s*<<([\s\S]*?)>>)");
-        boost::smatch trailer_match;
-        if (boost::regex_search(doc_core.doc_contents, trailer_match, trailer_regex)) { // if document has a trailer:
-            parse_doc_trailer(trailer_match[1]);
-            std::size_t xref_table_pos = doc_core.ref_struct.startxref;
-            parse_xref_table(xref_table_pos);
-            init_objects_root();
-            return 0;
+    // keeps the runs shown by the last operator, for textRunIterator. a TJ array can show several
+    struct textRunSlot : textVisitor {
+        std::vector<textRun> runs;
+        std::size_t current = 0;
+
+        void visit(const textRun& shown) override {
+            runs.push_back(shown);
         }
+    };
 
-        // parse PDF's xrefStream, decompressing any /ObjStm & generating the trailer from the compressed xref obj
-        boost::regex xref_stm_regex(R"(\d+\s+\d+\s+obj\s*<<((?:(?!/Type).)*?/Type\s*/XRef.*?>>\s*stream[\s\S]*?endstream)\s*endobj)");
-        boost::smatch xref_stm_match;
-        if (boost::regex_search(doc_core.doc_contents, xref_stm_match, xref_stm_regex)) {
-            parse_xref_stream(xref_stm_match[1]);
-            std::size_t xref_table_pos = doc_core.ref_struct.startxref;
-            parse_xref_table(xref_table_pos);
-            init_objects_root();
-            return 0;
+    struct textRunIterator::iteratorState {
+        textRunSlot slot;
+        pageContentCollector collector;
+        contentReader reader;
+        contentInterpreter interpreter;
+
+        iteratorState(page& pg, docCore& doc, const std::vector<objectRef>& content_refs)
+            : collector(pg, &slot, nullptr), reader(doc, content_refs), interpreter(collector) {
+            interpreter.start(reader);
         }
+    };
 
-        return 1; // if none of the above checks worked, then the file being parsed is obviously malformed, exit with return code 1
+    textRunIterator::textRunIterator(page& pg, docCore& doc) : state(std::make_unique<iteratorState>(pg, doc, pg.content_refs)) {}
+
+    textRunIterator::textRunIterator(textRunIterator&&) noexcept = default;
+    textRunIterator::~textRunIterator() = default;
+
+    // the interpreter is stepped an operator at a time until one shows text, once the runs the last one showed are used up
+    bool textRunIterator::next() {
+        textRunSlot& slot = state->slot;
+        if (++slot.current < slot.runs.size()) return true;
+        slot.runs.clear();
+        slot.current = 0;
+        while (slot.runs.empty() && state->interpreter.step()) {}
+        return !slot.runs.empty();
     }
 
+    const textRun& textRunIterator::operator*() const {
+        return state->slot.runs[state->slot.current];
+    }
 
-    int get_num_pages() {
-        return doc_core.objects_root.page_count;
+    const textRun* textRunIterator::operator->() const {
+        return &state->slot.runs[state->slot.current];
     }
 
-    page get_page(int page_num) {
-        return page(doc_core.objects_root.pages[page_num]);
+    /* pages are cheap handles, constructing one reads nothing. each stage (media box, resources, content stream) is loaded the first time
+    something needs it & kept for the page's lifetime, so e.g. laying out thumbnails only ever reads the page dictionaries */
+    page::page(std::shared_ptr<const document> doc, const pageEntry& entry)
+        : doc(std::move(doc)), page_ref(entry.ref), resources_obj(entry.resources), media_box_obj(entry.media_box), crop_box_obj(entry.crop_box),
+        rotate_obj(entry.rotate) {}
+
+    rect page::get_media_box() {
+        if (!media_box_loaded) {
+            media_box = parse_rect(*media_box_obj);
+            media_box_loaded = true;
+        }
+        return media_box;
     }
 
-    page::page(std::size_t page_ref) {
-        object_contents = isolate_object_contents(doc_core.doc_contents, page_ref);
+    rect page::get_crop_box() {
+        // defaults to the media box
+        return crop_box_obj->type == OBJ_ARRAY ? parse_rect(*crop_box_obj) : get_media_box();
+    }
 
-        media_box = parse_rect("/MediaBox", object_contents);
-        std::cout << media_box.bottom_left.x << media_box.bottom_left.y << media_box.top_right.x << media_box.top_right.y;
-    
-        std::size_t resources_pos = object_contents.find("/Resources"); // keep if needed in future
+    int page::get_rotation() {
+        // a multiple of 90, normalised to 0-270
+        int rotation = static_cast<int>(rotate_obj->type == OBJ_INTEGER ? rotate_obj->int_value % 360 : 0);
+        if (rotation < 0) rotation += 360;
+        return rotation - rotation % 90;
+    }
 
+    void page::load_resources() {
+        if (resources_loaded) return;
+        resources_loaded = true;
         // parse font objects for page
-        font_refs = parse_obj_ref_dict("/Font", object_contents);
-        x_obj_refs = parse_obj_ref_dict("/XObject", object_contents);
+        const pdfObject& resources = *resources_obj; // inherited from the page tree when the page doesn't set its own
+        font_refs = parse_obj_ref_dict(resources.get("/Font"));
+        x_obj_refs = parse_obj_ref_dict(resources.get("/XObject"));
         check_x_obj_type(); // check which XObject type each mapped key represents & save them to a vector
-        contents = parse_content_stream(parse_obj_ref("/Contents", object_contents));
     }
 
-    rect page::get_media_box() {
-        return media_box;
+    // /Contents is either a single stream or an array of streams to be read as one, in order
+    void page::load_contents() {
+        if (contents_loaded) return;
+        contents_loaded = true;
+        const pdfObject* contents = get_object(*doc->core, page_ref).find("/Contents");
+        if (!contents) return;
+        if (contents->type == OBJ_REF && resolve(*contents).type == OBJ_ARRAY) contents = &resolve(*contents); // an array stored as its own object
+        if (contents->type == OBJ_REF) content_refs.push_back(contents->ref);
+        else if (contents->type == OBJ_ARRAY) {
+            for (const pdfObject& part : contents->array) {
+                if (part.type == OBJ_REF) content_refs.push_back(part.ref);
+            }
+        }
     }
 
     page::~page() {}
-    
-    page::pageContent page::parse_content_stream(std::size_t content_stream_ref) {
-        pageContent contents;
-        std::string object_contents = isolate_object_contents(doc_core.doc_contents, content_stream_ref);
-        // decompress & save stream
-        boost::regex stream_regex(R"(stream\s*\n((?:(?!endstream)[\s\S])*)\s*endstream)");
-        boost::smatch stream_match;
-        boost::regex_search(object_contents, stream_match, stream_regex);
-        contents.stream = inflate_stream_to_str(stream_match[1]);
-        std::cout << contents.stream;
-        return contents;
+
+    /* runs the content streams through the interpreter once, passing text runs to text & collecting images into images, either of which may be
+    null. the streams are decoded as they are interpreted, a window at a time, & aren't kept by the page */
+    void page::visit_contents(textVisitor* text, std::vector<imageObject>* images) {
+        load_resources();
+        load_contents();
+        pageContentCollector collector(*this, text, images);
+        contentInterpreter interpreter(collector);
+        contentReader reader(*doc->core, content_refs);
+        interpreter.run(reader);
     }
 
-    // NOTE: add ability to also parse the graphics state properties given to text objects before the BT symbol
+    // the text objects & images, either output may be null
+    void page::parse_contents(std::vector<textObject>* text_objs, std::vector<imageObject>* images) {
+        if (!text_objs) return visit_contents(nullptr, images);
+        textObjectBuilder builder(*this, *text_objs);
+        visit_contents(&builder, images);
+    }
 
-    std::vector<textObject> page::parse_text_objects() {
-        std::vector<textObject> text_objs;
-        boost::regex text_obj_regex(R"(BT(.*?)ET)");
-        boost::sregex_iterator iter(contents.stream.begin(), contents.stream.end(), text_obj_regex);
-        boost::sregex_iterator end;
-
-        while (iter != end) {
-            textObject obj;
-            std::string obj_content = (*iter)[1].str();  // Capture the content between BT and ET
-            // parse coords
-            if (std::size_t pos = obj_content.find("Td"); pos != std::string::npos) {
-                std::istringstream(obj_content.substr(obj_content.rfind("\n", pos) + 1, pos)) >> obj.text_coordinates.x >> obj.text_coordinates.y;
-            }
-            // find text blocks
-            std::vector<std::size_t> text_block_positions;
-            boost::regex text_block_regex(R"(/(\w+)\s*(\d+)\s*Tf\s*((?:\((.*?)\)Tj\s*)+))");
-            boost::sregex_iterator text_iter(obj_content.begin(), obj_content.end(), text_block_regex);
-            while (text_iter != end) {
-                textData text_block;
-                text_block.font = load_font((*text_iter)[1]);
-                text_block.text_size = std::stoi((*text_iter)[2]);
+    void page::visit_text(textVisitor& visitor) {
+        visit_contents(&visitor, nullptr);
+    }
 
-                std::string text_content = (*text_iter)[3].str();
-                boost::regex text_regex(R"(\((.*?)\)Tj)");
-                boost::sregex_iterator text_content_iter(text_content.begin(), text_content.end(), text_regex);
-                while (text_content_iter != end) {
-                    text_block.text += (*text_content_iter)[1].str();
-                    ++text_content_iter;
-                }
+    textRunIterator page::iterate_text() {
+        load_resources();
+        load_contents();
+        return textRunIterator(*this, *doc->core);
+    }
 
-                obj.text_blocks.push_back(text_block);
-                ++text_iter;
-            }
-            text_objs.push_back(obj);
-            ++iter;
-        }
+    std::vector<textObject> page::parse_text_objects() {
+        std::vector<textObject> text_objs;
+        parse_contents(&text_objs, nullptr);
         return text_objs;
     }
 
     std::shared_ptr<fontObject> page::load_font(const std::string& font_key) {
-        // check if font is not already loaded, if it is, return the font for use
-        auto font_iter = font_cache.find(font_key);
-        if (font_iter != font_cache.end()) {
-            return font_iter->second;
-        }
-        // if font isn't loaded find its entry on the font ref map by the provided key
+        // find the font's entry on the font ref map by the provided key, fonts are parsed once per document & shared between its pages
         auto font_ref_iter = font_refs.find(font_key);
         if (font_ref_iter == font_refs.end()) {
             throw std::runtime_error("No reference found for font object with key: " + font_key);
         }
-        // parse font object & save to chache
-        std::string obj_content = isolate_object_contents(doc_core.doc_contents, font_ref_iter->second);
-        std::shared_ptr<fontObject> font = std::make_shared<fontObject>();
-        font->font_name = get_tag_type(obj_content.find("/BaseFont"), obj_content);
-        font->subtype = get_tag_value(obj_content.find("/Subtype"), obj_content);
-        font_cache.emplace(font_key, font);
-        return font;
+        return get_font(*doc->core, font_ref_iter->second);
     }
 
     void page::check_x_obj_type() {
         for (const auto& ref : x_obj_refs) {
             const std::string& key = ref.first;
-            std::string x_obj_contents = isolate_object_contents(doc_core.doc_contents, ref.second);
-            std::string type = get_tag_type(x_obj_contents.find("/Subtype", 0), x_obj_contents);
+            const std::string& type = get_x_obj_info(*doc->core, ref.second)->subtype;
             if (type == "/Image") image_keys.push_back(key);
             if (type == "/Form") form_keys.push_back(key);
         }
@@ -829,112 +4157,27 @@ namespace pdf_parser {
 
     std::vector<imageObject> page::parse_page_images() {
         std::vector<imageObject> imgs;
-        boost::regex x_obj_regex(R"(q\s+([\s\S]*?)/(\w+)\s+Do\s+Q)"); // this gathers any calls for xObjects in the contents
-        boost::smatch x_obj_match;
-        std::string::const_iterator start = contents.stream.begin();
-        std::string::const_iterator end = contents.stream.end();
-        while (boost::regex_search(start, end, x_obj_match, x_obj_regex)) {
-            std::string graphics_state = x_obj_match[1].str(); // Capture the graphics state info preceeding the '<key> Do' call
-            std::string x_obj_key = x_obj_match[2].str(); // used key
-            if (std::find(image_keys.begin(), image_keys.end(), x_obj_key) != image_keys.end()) { // if this succeeds the called XObject is an image
-                imageObject img;
-                std::string object_contents = isolate_object_contents(doc_core.doc_contents, x_obj_refs[x_obj_key]);
-                // parse graphics state
-                std::istringstream ctm_stream(graphics_state); 
-                ctm_stream >> img.graphics_state.ctm.scale_x >> img.graphics_state.ctm.shear_y >> img.graphics_state.ctm.shear_x
-                >> img.graphics_state.ctm.scale_y >> img.graphics_state.ctm.translate_x >> img.graphics_state.ctm.translate_y;
-                // image width & height
-                std::size_t width_pos = object_contents.find("/Width", 0);
-                img.width = get_tag_value(width_pos, object_contents);
-                std::size_t height_pos = object_contents.find("/Height", 0);
-                img.height = get_tag_value(height_pos, object_contents);
-                // extract bits per component
-                std::size_t bits_per_component_pos = object_contents.find("/BitsPerComponent", 0);
-                img.bits_per_component = get_tag_value(bits_per_component_pos, object_contents);
-                // get colour space
-                std::size_t colour_space_pos = object_contents.find("/ColorSpace", 0);
-                std::string colour_space = get_tag_type(colour_space_pos, object_contents);
-                if (colour_space == "/DeviceRGB") img.clr_space = DEVICE_RGB;
-                if (colour_space == "/DeviceCMYK") img.clr_space = DEVICE_CMYK;
-                // check interpolate bool value
-                std::size_t interpolate_pos = object_contents.find("/Interpolate", 0);
-                img.interpolate = get_tag_bool_value(interpolate_pos, object_contents);
-                // decompress image stream
-                boost::regex stream_regex(R"(stream\s*\n((?:(?!endstream)[\s\S])*)\s*endstream)");
-                boost::smatch stream_match;
-                boost::regex_search(object_contents, stream_match, stream_regex);
-                img.image_stream = inflate_stream_to_raw(std::vector<uint8_t>(stream_match[1].begin(), stream_match[1].end()));
-                imgs.push_back(img);
-            }
-            start = x_obj_match[0].second;
-        }
+        parse_contents(nullptr, &imgs);
         return imgs;
     }
 
-
-std::vector<uint8_t> page::inflate_stream_to_raw(const std::vector<uint8_t>& deflated_stream) {
-    z_stream stream{};
-    int ret = inflateInit(&stream);
-
-    std::vector<uint8_t> inflated_stream;
-    const int chunk_size = 16384; // 16 KB chunk size
-    std::vector<uint8_t> buffer(chunk_size);
-
-    stream.next_in = const_cast<Bytef*>(deflated_stream.data());
-    stream.avail_in = static_cast<uInt>(deflated_stream.size());
-
-    while (ret != Z_STREAM_END) {
-        stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
-        stream.avail_out = chunk_size;
-
-        ret = inflate(&stream, Z_NO_FLUSH);
-        if (ret == Z_STREAM_ERROR || ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
-            inflateEnd(&stream);
-            return {}; // Return an empty vector on error
-        }
-
-        inflated_stream.insert(inflated_stream.end(), buffer.data(), buffer.data() + chunk_size - stream.avail_out);
-    }
-
-    inflateEnd(&stream);
-
-    return inflated_stream;
-}
-
-std::string page::inflate_stream_to_str(const std::string& deflated_stream) {
-    z_stream zs{};
-    zs.zalloc = Z_NULL;
-    zs.zfree = Z_NULL;
-    zs.opaque = Z_NULL;
-    zs.avail_in = 0;
-    zs.next_in = Z_NULL;
-
-    int ret = inflateInit(&zs); // Allow zlib and gzip decoding
-    if (ret != Z_OK) {
-        throw std::runtime_error("inflateInit2 failed");
+    // decodes the image XObject x_obj_key names, if it is one, & adds it to imgs. forms aren't entered
+    void page::add_image(const std::string& x_obj_key, const graphicsState& graphics_state, std::vector<imageObject>& imgs) {
+        if (std::find(image_keys.begin(), image_keys.end(), x_obj_key) == image_keys.end()) return;
+        imageObject img{};
+        objectRef x_obj_ref = x_obj_refs[x_obj_key];
+        std::shared_ptr<const xObjectInfo> info = get_x_obj_info(*doc->core, x_obj_ref); // the image's metadata, read once per document
+        img.graphics_state = graphics_state;
+        img.width = info->width;
+        img.height = info->height;
+        img.bits_per_component = info->bits_per_component;
+        img.clr_space = info->clr_space;
+        img.interpolate = info->interpolate;
+        // decode image stream, its decoded size is known from the image's dimensions. image codecs such as /DCTDecode are left encoded
+        const pdfObject& x_obj = get_object(*doc->core, x_obj_ref);
+        std::size_t row_size = (static_cast<std::size_t>(std::max(img.width, 0)) * info->components * std::max(img.bits_per_component, 0) + 7) / 8;
+        img.filter = decode_stream(x_obj, img.image_stream, row_size * std::max(img.height, 0));
+        imgs.push_back(std::move(img));
     }
-    std::string decompressed_data;
-    std::vector<char> out_buffer(32768);
-
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(deflated_stream.data()));
-    zs.avail_in = static_cast<uInt>(deflated_stream.size());
-
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(out_buffer.data());
-        zs.avail_out = static_cast<uInt>(out_buffer.size());
-
-        ret = inflate(&zs, Z_NO_FLUSH);
-        if (ret == Z_STREAM_ERROR) {
-            inflateEnd(&zs);
-            throw std::runtime_error("inflate failed");
-        }
-
-        decompressed_data.insert(decompressed_data.end(), out_buffer.begin(), out_buffer.begin() + out_buffer.size() - zs.avail_out);
-    } while (ret != Z_STREAM_END);
-
-    inflateEnd(&zs);
-    return decompressed_data;
-}
-
 
 }
\ No newline at end of file
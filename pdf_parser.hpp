@@ -5,15 +5,14 @@
 
 /* VERSION 0.1_01, THIS LIBRARY IS IN 'ALPHA' & SHOULD NOT BE USED SERIOUSLY ASIDE FROM IN TESTING DUE TO BUGINESS & MISSING FEATURES 
 this PDF parser as of now supports:
-- text parsing, with fonts, text size & coordinates
+- text parsing, with fonts, text size & coordinates, decoded to UTF-8 through the fonts' encodings & ToUnicode CMaps
 - image XObject parsing assuming it is encoded in RGB with DEFLATE algorithm 
-- can parse all standard PDF files version 1.5+, also supports xref streams & compression of objects, but does not support linearisation & non-standard or
-more infrequents formats such as PDF/A, may also sometimes have trouble on certain adobe generated PDFs due to acrobat's tendency to use strange layouts or structs
+- can parse all standard PDF files version 1.5+, also supports xref streams & compression of objects & linearised files, whose first page is parsed
+using only the start of the file. does not support non-standard or more infrequents formats such as PDF/A, may also sometimes have trouble on certain adobe generated PDFs due to acrobat's tendency to use strange layouts or structs
 - is for now, only a viewer, not an editor
 
 The library itself has been tested on a few basic PDF documents, real-world testing was done where a PDF representing a Twinkl(R) worksheet was parsed
 without any issue. This library is known to crash when:
-- contents are in the non-standard format of having reference to more than one stream object
 - xrefs are in a non-standard format
 - any data is corrupted (even 1 byte of corrupted data could cause this thing to crash)
 - encountering any kind of unexpected tag in an object or unexpected value
@@ -22,24 +21,37 @@ PLANS:
 - support form functinality (AcroForms)
 - support basic table / rect rendering
 - improve stability
-
-Linearisation is a more complex feature that may or may not be supported later on, but for now only small code fragments exist as a foundation if this is ever added
 */
 
 /* This is a file of the PDF_Coder library */
 
-#include <boost/regex.hpp> // STL regex is not very well optimised & is not overall that good of a parser. Boost's regex lib is better
-
 /* c++ STL */
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+#include <unordered_set>
 #include <array>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <cstdint> // for uint8_t & uint64_t
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <functional>
+#include <random>
 
 /* zlib handles stream compression & decompression using the DEFLATE algorithm. It is a native linux lib */
 #include <zlib.h>
@@ -47,7 +59,19 @@ Linearisation is a more complex feature that may or may not be supported later o
 namespace pdf_parser {
 
 	enum streamFilter : int {
-		FLATE_DECODE_FILTER
+		NO_FILTER,
+		FLATE_DECODE_FILTER,
+		LZW_DECODE_FILTER,
+		ASCII_HEX_DECODE_FILTER,
+		ASCII_85_DECODE_FILTER,
+		RUN_LENGTH_DECODE_FILTER,
+		// image codecs, stream data using them is handed over still encoded
+		DCT_DECODE_FILTER,
+		JPX_DECODE_FILTER,
+		CCITT_FAX_DECODE_FILTER,
+		JBIG2_DECODE_FILTER,
+		CRYPT_FILTER,
+		UNKNOWN_FILTER
 	};
 
 	enum streamPredictor : int {
@@ -59,6 +83,25 @@ namespace pdf_parser {
 		PNG_OPTIMUM
 	};
 
+	// how open() backs the document bytes. mapped keeps the file in a read-only memory map & every parse step works on views into it
+	enum loadMode : int {
+		LOAD_MAPPED,
+		LOAD_BUFFERED, // read the file once into an owned buffer, for filesystems where mmap isn't wanted
+		LOAD_ON_DEMAND // only read the byte ranges the parser needs, as they are needed. see byteSource
+	};
+
+	/* where an opened document's bytes come from, for documents which aren't (or aren't yet) fully available, e.g. served over the network with
+	range requests. the parser asks only for the ranges it needs (the file's tail for startxref, the xref sections & the objects it parses) in
+	chunks of at least 16 KB. read() can be called from any thread parsing the document, but never by two at once. a failed read makes open()
+	return nullptr, or makes the page call which needed the bytes throw std::runtime_error */
+	class byteSource {
+	public:
+		virtual ~byteSource() = default;
+		virtual std::size_t size() = 0; // the document's total length in bytes
+		// copies the length bytes at offset into out, returns false if they can't be read
+		virtual bool read(std::size_t offset, std::size_t length, char* out) = 0;
+	};
+
 	enum colour_space : int {
 		DEVICE_RGB,
 		DEVICE_CMYK
@@ -104,7 +147,7 @@ namespace pdf_parser {
 		int bits_per_component;
 		bool interpolate;
 		colour_space clr_space;
-		streamFilter filter;
+		streamFilter filter; // the first filter left undecoded in image_stream, NO_FILTER once fully decoded
 	};
 
 	/* graphics-related structs */
@@ -121,13 +164,45 @@ namespace pdf_parser {
 
 	/* text-related structures */
 
+	enum fontSubtype : int {
+		FONT_UNKNOWN,
+		FONT_TYPE1,
+		FONT_MM_TYPE1,
+		FONT_TRUETYPE,
+		FONT_TYPE3,
+		FONT_TYPE0 // composite (CID) fonts, whose codes are 2 bytes
+	};
+
+	// where a character code's text is in a fontObject's text_pool
+	struct codeMapping {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	// 2-byte codes first to last map to consecutive code points from unicode, or a single code maps to text in the pool when text.length isn't 0
+	struct codeRange {
+		uint16_t first;
+		uint16_t last;
+		char32_t unicode;
+		codeMapping text;
+	};
+
+	/* a font & the tables decoding the codes shown with it to Unicode, built once from its /Encoding, /Differences & /ToUnicode CMap when the
+	font is first used in the document. fonts with 1-byte codes use a direct table, 2-byte ones a sorted list of ranges */
 	struct fontObject {
 		std::string font_name;
-		int subtype;
+		int subtype; // a fontSubtype
+		int code_length = 1; // bytes per character code
+		std::array<codeMapping, 256> byte_codes{}; // for 1-byte codes, unmapped codes have no text
+		std::vector<codeRange> code_ranges; // for 2-byte codes, sorted by first
+		std::string text_pool; // UTF-8
+
+		// appends the text shown by the codes (e.g. a textRun's text) to out as UTF-8. unmapped 2-byte codes are U+FFFD
+		void decode(std::string_view codes, std::string& out) const;
 	};
 
 	struct textData {
-		std::string text;
+		std::string text; // UTF-8, decoded through the font's encoding
 		int text_size;
 		std::shared_ptr<fontObject> font;
 	};
@@ -137,6 +212,12 @@ namespace pdf_parser {
 		std::vector<textData> text_blocks;
 	};
 
+	/* used in other structs to store obj & gen num of specific refrenced objects */
+	struct objectRef {
+		int obj_num;
+		int gen_num;
+	};
+
 	/* External objects */
 
 	struct xObject {
@@ -144,37 +225,110 @@ namespace pdf_parser {
 		std::size_t pos;
 	};
 	
+	struct docCore; // a document's state, internal to pdf_parser.cpp
+	struct pdfObject;
+	struct pageEntry;
+	class document;
+	class page;
+	class pageContentCollector;
+	class textObjectBuilder;
+
+	/* a string shown by one text operator, as passed to a textVisitor. a TJ array is split into several runs where it leaves a word sized gap.
+	text & font_key point into the content being parsed & are only valid until the visitor returns (or the iterator moves on), font is owned by
+	the document's font cache & is valid for as long as the document */
+	struct textRun {
+		std::string_view text; // the string's bytes, in the font's encoding
+		std::string_view font_key; // the font's name in the page's /Font resources
+		const fontObject* font;
+		double font_size;
+		coordinates position; // where the run starts, in default user space
+		bool space_before = false; // the run follows a gap in the same TJ array wide enough to be a space between words
+	};
+
+	// receives a page's text runs in content stream order, straight from the parse. see page::visit_text()
+	class textVisitor {
+	public:
+		virtual ~textVisitor() = default;
+		virtual void begin_text_object() {} // BT
+		virtual void end_text_object() {} // ET
+		virtual void visit(const textRun& run) = 0;
+	};
+
+	/* a textVisitor keeping every run, for callers who want them all at once. the runs' text is copied into 64 KB blocks owned by the collector,
+	so collecting a page costs a handful of allocations however many runs it has. the runs are valid for as long as the collector */
+	class textRunCollector : public textVisitor {
+	public:
+		void visit(const textRun& run) override;
+		const std::vector<textRun>& get_runs() const { return runs; }
+
+	private:
+		std::string_view store(std::string_view text); // copies text into the current block
+
+		std::vector<textRun> runs;
+		std::vector<std::unique_ptr<char[]>> blocks;
+		std::size_t block_size = 0;
+		std::size_t block_used = 0;
+	};
+
+	/* pulls a page's text runs one at a time, parsing only as far as the next run. the current run is valid until next() is called again & the
+	page has to outlive the iterator. use as: for (textRunIterator it = pg.iterate_text(); it.next();) { it->text ... } */
+	class textRunIterator {
+	public:
+		textRunIterator(textRunIterator&&) noexcept;
+		~textRunIterator();
+		bool next(); // moves to the next run, returns false once there are none left
+		const textRun& operator*() const;
+		const textRun* operator->() const;
+
+	private:
+		friend class page;
+		struct iteratorState; // the interpreter state, internal to pdf_parser.cpp
+		textRunIterator(page& pg, docCore& doc);
+		std::unique_ptr<iteratorState> state;
+	};
+
 	class page {
     public:
-		page(std::size_t page_ref);
+		page(std::shared_ptr<const document> doc, const pageEntry& entry);
 		~page();
 		std::vector<imageObject> parse_page_images();
         std::vector<textObject> parse_text_objects(); // parse text objects inside a stream
+		void visit_text(textVisitor& visitor); // passes the page's text runs to visitor as they are parsed, without building textObjects
+		textRunIterator iterate_text();
 		rect get_media_box();
+		rect get_crop_box();
+		int get_rotation(); // clockwise degrees, 0, 90, 180 or 270
 
 	private:
-	    struct pageContent {
-		    std::string stream;
-		    streamFilter filter;
-	    };
-
-		pageContent parse_content_stream(std::size_t content_stream_ref); 
+		friend class document;
+		friend class pageContentCollector;
+		friend class textObjectBuilder;
+		friend class textRunIterator;
 
-		std::string inflate_stream_to_str(const std::string &deflated_stream);					 // for contents streams
-		std::vector<uint8_t> inflate_stream_to_raw(const std::vector<uint8_t> &deflated_stream); // for image streams
+		void load_resources(); // fills font_refs, x_obj_refs, image_keys & form_keys on first use
+		void load_contents(); // fills content_refs on first use
+		void parse_contents(std::vector<textObject>* text_objs, std::vector<imageObject>* images);
+		void visit_contents(textVisitor* text, std::vector<imageObject>* images);
+		void add_image(const std::string& x_obj_key, const graphicsState& graphics_state, std::vector<imageObject>& imgs);
 
 		std::shared_ptr<fontObject> load_font(const std::string &font_key);
         void check_x_obj_type();
 
+		std::shared_ptr<const document> doc; // keeps the document alive for as long as its pages are
+		objectRef page_ref;
+		// the page's attributes, inherited from the page tree when the page doesn't set them. they point into the document's object cache
+		const pdfObject* resources_obj;
+		const pdfObject* media_box_obj;
+		const pdfObject* crop_box_obj;
+		const pdfObject* rotate_obj;
+		bool media_box_loaded = false;
+		bool resources_loaded = false;
+		bool contents_loaded = false;
 		rect media_box;
-		std::map<std::string, std::size_t> font_refs;
-		std::map<std::string, std::size_t> x_obj_refs; // XObjects
-		std::size_t content_refs; // refs to contents obj
+		std::map<std::string, objectRef> font_refs;
+		std::map<std::string, objectRef> x_obj_refs; // XObjects
+		std::vector<objectRef> content_refs; // the /Contents streams, in the order they are read
 		int object_gen_number;
-		std::string object_contents;
-        
-		pageContent contents; // content stream
-		std::map<std::string, std::shared_ptr<fontObject>> font_cache;
 
         /* XObjects can either be forms or images, when a ref to an XObject is found in a stream,
 		what that XObject is must first be determined to properly parse it. So when XObject are first mapped with their keys & positions, the types
@@ -183,9 +337,54 @@ namespace pdf_parser {
 		std::vector<std::string> form_keys;
 	};
 
-	int open(std::string path);
-	page get_page(int page_num);
-	int get_num_pages();
+	// a page's contents, as returned by document::parse_all_pages()
+	struct pageResult {
+		rect media_box;
+		std::vector<textObject> text_objects;
+		std::vector<imageObject> images;
+	};
+
+	// lookups in a document's font & XObject cache, see document::get_resource_cache_stats()
+	struct resourceCacheStats {
+		uint64_t hits;
+		uint64_t misses; // each miss is a resource parsed
+	};
+
+	// an opened PDF, returned by open(). pages hold a shared_ptr to the document they come from
+	class document : public std::enable_shared_from_this<document> {
+	public:
+		explicit document(std::unique_ptr<docCore> core);
+		~document();
+		page get_page(int page_num) const;
+		int get_num_pages() const;
+
+		/* parses the text & images of every page on n_threads threads (0 for one per core), the calling thread being one of them. pages are
+		spread over the threads with work stealing & the results are returned in page order. if parsing a page throws, the first exception is
+		rethrown once every thread is done */
+		std::vector<pageResult> parse_all_pages(int n_threads = 0) const;
+
+		// fonts & XObjects are parsed once per document & shared by its pages, these count the lookups made in that cache so far
+		resourceCacheStats get_resource_cache_stats() const;
+
+		// bytes read from the document's source so far. documents opened from a file that isn't LOAD_ON_DEMAND read the whole file
+		std::size_t get_bytes_read() const;
+
+	private:
+		friend class page;
+		std::unique_ptr<docCore> core;
+	};
+
+	/* when index_path is given, the xref, /ObjStm offset tables & page list are loaded from the sidecar index file there if it matches the file's
+	size, modification time & trailer /ID. otherwise the file is parsed as usual & the index (re)written for the next open */
+	std::shared_ptr<document> open(std::string path, loadMode mode = LOAD_MAPPED, const std::string& index_path = "");
+	std::shared_ptr<document> open(std::unique_ptr<byteSource> source);
+	// opens a document held in memory without copying it, data has to outlive the document & its pages
+	std::shared_ptr<document> open_memory(const char* data, std::size_t size);
+
+	/* number of heap allocations made while decoding streams (output buffers growing, zlib states & decode pipeline stages) since the last reset,
+	e.g. to measure what parsing a page costs */
+	uint64_t get_decode_allocation_count();
+	void reset_decode_allocation_count();
 
 
 }